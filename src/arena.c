@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements arenas, which allocate memory that is released all at once
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+KERNEL_STATE struct Arena sessionArena = { 0 }; // The arena of the exec session
+
+// Rounds size up to a multiple of ARENA_ALIGNMENT
+size_t arenaRound(size_t size) {
+	if (size == 0) {
+		size = 1; // A released allocation must hold the link of its free list
+	}
+	return (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+}
+
+// Allocates size bytes from arena
+// The memory is valid until the arena is reset or it is released with arenaFree(), and it must not be freed
+void *arenaAlloc(struct Arena *arena, size_t size) {
+	size = arenaRound(size);
+
+	// Reuse an allocation of the same size that was released
+	size_t list = size / ARENA_ALIGNMENT - 1;
+	if (list < ARENA_FREE_LISTS && arena->freeLists[list] != NULL) {
+		void *memory = arena->freeLists[list];
+		arena->freeLists[list] = *(void **) memory;
+		arena->bytes += size;
+		if (arena->bytes > arena->peak) {
+			arena->peak = arena->bytes;
+		}
+		return memory;
+	}
+
+	// Move to the next block that was kept from before the last reset, if the current one is full
+	while (arena->current != NULL && arena->current->size - arena->current->used < size && arena->current->next != NULL) {
+		arena->current = arena->current->next;
+		arena->current->used = 0;
+	}
+
+	if (arena->current == NULL || arena->current->size - arena->current->used < size) {
+		size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+		struct ArenaBlock *block = (struct ArenaBlock *) malloc(sizeof(struct ArenaBlock) + blockSize);
+		block->next = NULL;
+		block->size = blockSize;
+		block->used = 0;
+
+		if (arena->current == NULL) {
+			arena->first = block;
+		} else {
+			arena->current->next = block;
+		}
+		arena->current = block;
+		arena->reserved += blockSize;
+		arena->blocks++;
+	}
+
+	void *memory = arena->current->data + arena->current->used;
+	arena->current->used += size;
+	arena->bytes += size;
+	if (arena->bytes > arena->peak) {
+		arena->peak = arena->bytes;
+	}
+
+	return memory;
+}
+
+// Copies the string str into arena
+char *arenaStrdup(struct Arena *arena, const char *str) {
+	size_t len = strlen(str);
+	char *copy = (char *) arenaAlloc(arena, len + 1);
+	memcpy(copy, str, len + 1);
+	return copy;
+}
+
+// Releases the allocation memory of size bytes before the arena is reset, so that the next allocation of that size reuses it
+// An allocation larger than the free lists allow is only released when the arena is reset.
+void arenaFree(struct Arena *arena, void *memory, size_t size) {
+	if (memory == NULL) {
+		return;
+	}
+
+	size = arenaRound(size);
+	arena->bytes -= size;
+
+	size_t list = size / ARENA_ALIGNMENT - 1;
+	if (list < ARENA_FREE_LISTS) {
+		*(void **) memory = arena->freeLists[list];
+		arena->freeLists[list] = memory;
+	}
+}
+
+// Releases the string str, which was copied into arena by arenaStrdup()
+void arenaFreeString(struct Arena *arena, char *str) {
+	if (str != NULL) {
+		arenaFree(arena, str, strlen(str) + 1);
+	}
+}
+
+// Releases every allocation of arena at once, without freeing its blocks
+// This takes constant time: the blocks after the first one are emptied when the allocations reach them again.
+void resetArena(struct Arena *arena) {
+	arena->current = arena->first;
+	if (arena->first != NULL) {
+		arena->first->used = 0;
+	}
+	arena->bytes = 0;
+	memset(arena->freeLists, 0, sizeof(arena->freeLists));
+}
+
+// Frees every block of arena, which can then be used again from scratch
+void freeArena(struct Arena *arena) {
+	struct ArenaBlock *block = arena->first;
+	while (block != NULL) {
+		struct ArenaBlock *next = block->next;
+		free(block);
+		block = next;
+	}
+
+	*arena = (struct Arena) { 0 };
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#include "state.h" // For KERNEL_STATE
+
+enum {
+	ARENA_BLOCK_SIZE = 64 * 1024, // The size of the blocks of memory that an arena allocates from
+	ARENA_ALIGNMENT = 16, // The alignment of the memory returned by an arena
+	ARENA_FREE_LISTS = 64 // The number of sizes of allocations, in multiples of ARENA_ALIGNMENT, that an arena recycles
+};
+
+// A block of memory that an arena allocates from
+struct ArenaBlock {
+	struct ArenaBlock *next; // The next block of the arena
+	size_t size; // The number of bytes in data
+	size_t used; // The number of bytes of data already allocated
+	char data[];
+};
+
+// An arena allocates memory by advancing through its blocks, and releases all of it at once
+// The blocks are kept when the arena is reset, so that the next allocations reuse them.
+// An allocation that is released early is kept on the free list of its size, and the next allocation of that size reuses it.
+// An arena must only be used by one thread.
+struct Arena {
+	struct ArenaBlock *first; // The first block of the arena
+	struct ArenaBlock *current; // The block that allocations are taken from
+	size_t bytes; // The number of bytes allocated since the arena was reset
+	size_t peak; // The largest number of bytes ever allocated at once
+	size_t reserved; // The number of bytes in the blocks of the arena
+	int blocks; // The number of blocks of the arena
+	void *freeLists[ARENA_FREE_LISTS]; // freeLists[i] links the released allocations of (i + 1) * ARENA_ALIGNMENT bytes
+};
+
+// The arena of the exec session, which holds the PCBs, the ready queue nodes and the lines loaded into RAM
+// A PCB and its node are released when the process terminates, and a line when its frame is reused, so the arena
+// only grows with the number of processes alive at once. The exec session ends, and the arena is reset, once no process remains.
+extern KERNEL_STATE struct Arena sessionArena;
+
+void *arenaAlloc(struct Arena *arena, size_t size);
+char *arenaStrdup(struct Arena *arena, const char *str);
+void arenaFree(struct Arena *arena, void *memory, size_t size);
+void arenaFreeString(struct Arena *arena, char *str);
+void resetArena(struct Arena *arena);
+void freeArena(struct Arena *arena);
+
+#endif
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file compiles scripts into a binary format (.kbc files) and loads compiled scripts
+// A compiled script is already split into pages and words, so the 'run' and 'exec' commands can
+// execute it without scanning, splitting or tokenizing its text. Compiled scripts are mapped into memory.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bytecode.h"
+#include "ram.h" // For PAGE_SIZE
+
+const char BYTECODE_MAGIC[8] = "MYKBC"; // Identifies a compiled script
+const char *BYTECODE_EXTENSION = ".kbc"; // The extension of compiled scripts
+
+// A growable array of 32-bit integers, used to build the sections of a compiled script
+struct WordBuffer {
+	uint32_t *words;
+	size_t count;
+	size_t capacity;
+};
+
+// Appends word to buffer
+void appendWord(struct WordBuffer *buffer, uint32_t word) {
+	if (buffer->count == buffer->capacity) {
+		buffer->capacity = buffer->capacity == 0 ? 256 : buffer->capacity * 2;
+		buffer->words = (uint32_t *) realloc(buffer->words, buffer->capacity * sizeof(uint32_t));
+	}
+
+	buffer->words[buffer->count++] = word;
+}
+
+// The string table being built by the compiler
+// Every distinct word is stored once, and a hash table maps the words to their index in the string table.
+struct StringInterner {
+	struct WordBuffer table; // The offset and the length of every string
+	char *data; // The characters of the strings, each followed by a null character
+	size_t dataSize;
+	size_t dataCapacity;
+	int32_t *slots; // The hash table: the index of a string in the table, or -1 for an empty slot
+	size_t slotCount; // The number of slots, which is a power of two
+};
+
+// Returns the FNV-1a hash of the len characters of str
+uint32_t hashWord(const char *str, size_t len) {
+	uint32_t hash = 2166136261u;
+	size_t i;
+	for (i = 0; i < len; i++) {
+		hash = (hash ^ (unsigned char) str[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+// Doubles the number of slots of the hash table of interner and inserts the strings again
+void growInterner(struct StringInterner *interner) {
+	free(interner->slots);
+	interner->slotCount = interner->slotCount == 0 ? 256 : interner->slotCount * 2;
+	interner->slots = (int32_t *) malloc(interner->slotCount * sizeof(int32_t));
+	memset(interner->slots, -1, interner->slotCount * sizeof(int32_t));
+
+	size_t i;
+	for (i = 0; i < interner->table.count / 2; i++) {
+		uint32_t offset = interner->table.words[2 * i], len = interner->table.words[2 * i + 1];
+		size_t slot = hashWord(interner->data + offset, len) & (interner->slotCount - 1);
+		while (interner->slots[slot] != -1) {
+			slot = (slot + 1) & (interner->slotCount - 1);
+		}
+		interner->slots[slot] = (int32_t) i;
+	}
+}
+
+// Returns the index of word in the string table, adding it if it is not there yet
+uint32_t internWord(struct StringInterner *interner, const char *word) {
+	size_t len = strlen(word);
+	if ((interner->table.count / 2 + 1) * 2 > interner->slotCount) { // Keep the hash table at most half full
+		growInterner(interner);
+	}
+
+	size_t slot = hashWord(word, len) & (interner->slotCount - 1);
+	while (interner->slots[slot] != -1) {
+		uint32_t i = (uint32_t) interner->slots[slot];
+		uint32_t offset = interner->table.words[2 * i];
+		if (interner->table.words[2 * i + 1] == len && memcmp(interner->data + offset, word, len) == 0) {
+			return i;
+		}
+		slot = (slot + 1) & (interner->slotCount - 1);
+	}
+
+	if (interner->dataSize + len + 1 > interner->dataCapacity) {
+		interner->dataCapacity = (interner->dataSize + len + 1) * 2;
+		interner->data = (char *) realloc(interner->data, interner->dataCapacity);
+	}
+
+	uint32_t index = (uint32_t) (interner->table.count / 2);
+	appendWord(&interner->table, (uint32_t) interner->dataSize);
+	appendWord(&interner->table, (uint32_t) len);
+	memcpy(interner->data + interner->dataSize, word, len + 1);
+	interner->dataSize += len + 1;
+	interner->slots[slot] = (int32_t) index;
+
+	return index;
+}
+
+// Returns 1 if filename has the extension of a compiled script, and 0 otherwise
+int isBytecodeFile(char *filename) {
+	size_t len = strlen(filename), extensionLen = strlen(BYTECODE_EXTENSION);
+	return len > extensionLen && strcmp(filename + len - extensionLen, BYTECODE_EXTENSION) == 0;
+}
+
+// Compiles the script source into the compiled script target
+// The lines are split into words like parse() does, and into pages like the 'exec' command does.
+// Returns 0 if the script was compiled, -1 if source could not be read, -2 if target could not be written,
+// and -3 if a line of source is longer than an instruction can be
+int compileScript(char *source, char *target) {
+	FILE *f = fopen(source, "r");
+	if (f == NULL) {
+		return -1;
+	}
+
+	struct BytecodeHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BYTECODE_MAGIC, sizeof(header.magic));
+	header.version = BYTECODE_VERSION;
+	header.sourceHash = 14695981039346656037UL; // The same hash as countTotalPages() in memorymanager.c
+
+	struct WordBuffer pageIndex = { 0 }, instructions = { 0 };
+	struct StringInterner interner = { 0 };
+	char *line = NULL;
+	size_t lineCapacity = 0;
+	ssize_t len;
+	int error = 0;
+
+	while ((len = getline(&line, &lineCapacity, f)) != -1) {
+		if (len > INSTRUCTION_SIZE - 2) {
+			error = -3;
+			break;
+		}
+
+		ssize_t i;
+		for (i = 0; i < len; i++) {
+			header.sourceHash = (header.sourceHash ^ (unsigned char) line[i]) * 1099511628211UL;
+		}
+		header.sourceSize += len;
+
+		if (header.lineCount % PAGE_SIZE == 0) {
+			appendWord(&pageIndex, (uint32_t) instructions.count);
+		}
+		header.lineCount++;
+
+		int newline = line[len - 1] == '\n';
+		if (newline) {
+			line[len - 1] = '\0';
+		}
+
+		size_t flagsPosition = instructions.count;
+		appendWord(&instructions, newline ? BYTECODE_NEWLINE : 0);
+		appendWord(&instructions, 0); // The number of words, which is known once the line has been split
+
+		char *state;
+		char *word = strtok_r(line, " ", &state);
+		while (word != NULL) {
+			appendWord(&instructions, internWord(&interner, word));
+			instructions.words[flagsPosition + 1]++;
+			word = strtok_r(NULL, " ", &state);
+		}
+	}
+
+	if (error == 0 && header.lineCount == 0) { // Like countTotalPages(), count an empty script as one empty line
+		appendWord(&pageIndex, 0);
+		appendWord(&instructions, 0);
+		appendWord(&instructions, 0);
+		header.lineCount = 1;
+	}
+
+	free(line);
+	fclose(f);
+
+	if (error == 0) {
+		header.pageCount = (uint32_t) pageIndex.count;
+		header.stringCount = (uint32_t) (interner.table.count / 2);
+		header.pageIndexOffset = sizeof(header);
+		header.stringTableOffset = header.pageIndexOffset + pageIndex.count * sizeof(uint32_t);
+		header.instructionsOffset = header.stringTableOffset + interner.table.count * sizeof(uint32_t);
+		header.instructionsSize = (uint32_t) instructions.count;
+		header.stringDataOffset = header.instructionsOffset + instructions.count * sizeof(uint32_t);
+		header.stringDataSize = (uint32_t) interner.dataSize;
+
+		FILE *out = fopen(target, "wb");
+		if (out == NULL) {
+			error = -2;
+		} else {
+			fwrite(&header, sizeof(header), 1, out);
+			fwrite(pageIndex.words, sizeof(uint32_t), pageIndex.count, out);
+			fwrite(interner.table.words, sizeof(uint32_t), interner.table.count, out);
+			fwrite(instructions.words, sizeof(uint32_t), instructions.count, out);
+			fwrite(interner.data, 1, interner.dataSize, out);
+			if (ferror(out)) {
+				error = -2;
+			}
+			if (fclose(out) != 0) {
+				error = -2;
+			}
+		}
+	}
+
+	free(pageIndex.words);
+	free(instructions.words);
+	free(interner.table.words);
+	free(interner.data);
+	free(interner.slots);
+	return error;
+}
+
+// Returns 1 if the section of count elements of elementSize bytes at offset lies inside a file of size bytes and is aligned
+int validSection(size_t size, uint32_t offset, size_t count, size_t elementSize) {
+	return offset % sizeof(uint32_t) == 0 && offset <= size && count <= (size - offset) / elementSize;
+}
+
+// Checks that every offset and index of the compiled script bc is in bounds, so that it can be decoded safely
+// Returns 0 if the compiled script is valid, and -1 otherwise
+int validateBytecode(struct Bytecode *bc) {
+	const struct BytecodeHeader *h = bc->header;
+	if (memcmp(h->magic, BYTECODE_MAGIC, sizeof(h->magic)) != 0 || h->version != BYTECODE_VERSION
+			|| !validSection(bc->size, h->pageIndexOffset, h->pageCount, sizeof(uint32_t))
+			|| !validSection(bc->size, h->stringTableOffset, 2 * (size_t) h->stringCount, sizeof(uint32_t))
+			|| !validSection(bc->size, h->instructionsOffset, h->instructionsSize, sizeof(uint32_t))
+			|| h->stringDataOffset > bc->size || h->stringDataSize > bc->size - h->stringDataOffset
+			|| h->lineCount == 0 || h->pageCount != ((uint64_t) h->lineCount + PAGE_SIZE - 1) / PAGE_SIZE) {
+		return -1;
+	}
+
+	uint32_t i;
+	for (i = 0; i < h->stringCount; i++) {
+		uint32_t offset = bc->stringTable[2 * i], len = bc->stringTable[2 * i + 1];
+		if (offset >= h->stringDataSize || len >= h->stringDataSize - offset || bc->stringData[offset + len] != '\0') {
+			return -1;
+		}
+	}
+
+	// Walk the instructions: every word must be in the string table, and every page must start where the page index says
+	uint32_t position = 0;
+	for (i = 0; i < h->lineCount; i++) {
+		if (i % PAGE_SIZE == 0 && bc->pageIndex[i / PAGE_SIZE] != position) {
+			return -1;
+		}
+		if (h->instructionsSize - position < 2) {
+			return -1;
+		}
+
+		uint32_t count = bc->instructions[position + 1];
+		if (count > BYTECODE_MAX_WORDS || h->instructionsSize - position - 2 < count) {
+			return -1;
+		}
+
+		uint32_t j;
+		for (j = 0; j < count; j++) {
+			if (bc->instructions[position + 2 + j] >= h->stringCount) {
+				return -1;
+			}
+		}
+
+		position += 2 + count;
+	}
+
+	return 0;
+}
+
+// Maps the compiled script filename into memory
+// Returns the compiled script, or NULL with error set to -1 if the file could not be read and to -2 if it is not a valid compiled script
+struct Bytecode *mapBytecode(char *filename, int *error) {
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		*error = -1;
+		return NULL;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		*error = -1;
+		return NULL;
+	}
+	if ((size_t) st.st_size < sizeof(struct BytecodeHeader)) {
+		close(fd);
+		*error = -2;
+		return NULL;
+	}
+
+	// The mapping is writable but private, so the words can be passed to the interpreter without modifying the file
+	void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		*error = -1;
+		return NULL;
+	}
+
+	struct Bytecode *bc = (struct Bytecode *) malloc(sizeof(struct Bytecode));
+	bc->data = (char *) data;
+	bc->size = st.st_size;
+	bc->header = (const struct BytecodeHeader *) data;
+	bc->pageIndex = (const uint32_t *) (bc->data + bc->header->pageIndexOffset);
+	bc->stringTable = (const uint32_t *) (bc->data + bc->header->stringTableOffset);
+	bc->instructions = (const uint32_t *) (bc->data + bc->header->instructionsOffset);
+	bc->stringData = bc->data + bc->header->stringDataOffset;
+
+	if (validateBytecode(bc) != 0) {
+		unmapBytecode(bc);
+		*error = -2;
+		return NULL;
+	}
+
+	*error = 0;
+	return bc;
+}
+
+// Unmaps a compiled script returned by mapBytecode()
+void unmapBytecode(struct Bytecode *bc) {
+	munmap(bc->data, bc->size);
+	free(bc);
+}
+
+// Returns the position of the first instruction of page in the instructions of bc
+uint32_t firstInstruction(struct Bytecode *bc, int page) {
+	return bc->pageIndex[page];
+}
+
+// Decodes the instruction at position in bc into words, which is terminated by NULL, and moves position to the next instruction
+// newline is set to 1 if the line ended with a new line character in the source script
+// Returns the number of words
+int decodeInstruction(struct Bytecode *bc, uint32_t *position, char *words[], int *newline) {
+	const uint32_t *instruction = bc->instructions + *position;
+	int count = (int) instruction[1];
+
+	int i;
+	for (i = 0; i < count; i++) {
+		words[i] = bc->stringData + bc->stringTable[2 * instruction[2 + i]];
+	}
+	words[count] = NULL;
+
+	*newline = instruction[0] & BYTECODE_NEWLINE;
+	*position += 2 + count;
+	return count;
+}
+
+// Writes the instruction at position in bc into buffer as a line of text, and moves position to the next instruction
+// The words are separated by single spaces, and the line ends with a new line character if it did in the source script,
+// except for the last line of a page, like in the page files of the backing store
+// Returns the length of the line
+int formatInstruction(struct Bytecode *bc, uint32_t *position, char *buffer, int size, int lastOfPage) {
+	char *words[BYTECODE_MAX_WORDS + 1];
+	int newline;
+	int count = decodeInstruction(bc, position, words, &newline);
+
+	int len = 0;
+	int i;
+	for (i = 0; i < count && len < size - 1; i++) {
+		len += snprintf(buffer + len, size - len, i == 0 ? "%s" : " %s", words[i]);
+	}
+	if (len > size - 2) {
+		len = size - 2;
+	}
+
+	if (newline && !lastOfPage) {
+		buffer[len++] = '\n';
+	}
+	buffer[len] = '\0';
+
+	return len;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h" // For INSTRUCTION_SIZE
+
+enum {
+	BYTECODE_VERSION = 1, // The version of the compiled script format
+	BYTECODE_MAX_WORDS = INSTRUCTION_SIZE / 2, // The maximum number of words in an instruction
+	BYTECODE_NEWLINE = 1 // The flag of an instruction whose line ends with a new line character in the source script
+};
+
+// The header of a compiled script (.kbc file)
+// A compiled script is made of the header, followed by these sections:
+// - The page index: the position in the instructions of the first instruction of every page
+// - The string table: the offset and the length of every distinct word in the string data
+// - The instructions: for every line, its flags, its number of words, and the index of each word in the string table
+// - The string data: the characters of every distinct word, each followed by a null character
+// Offsets are in bytes from the beginning of the file, and every number is stored in the byte order of the machine.
+struct BytecodeHeader {
+	char magic[8]; // BYTECODE_MAGIC
+	uint32_t version; // BYTECODE_VERSION
+	uint32_t lineCount; // The number of lines of the source script
+	uint32_t pageCount; // The number of pages of the source script
+	uint32_t stringCount; // The number of entries in the string table
+	uint64_t sourceHash; // The hash of the source script, as computed when a text script is launched
+	int64_t sourceSize; // The number of characters in the source script
+	uint32_t pageIndexOffset;
+	uint32_t stringTableOffset;
+	uint32_t instructionsOffset;
+	uint32_t instructionsSize; // The size of the instructions in 32-bit words
+	uint32_t stringDataOffset;
+	uint32_t stringDataSize; // The size of the string data in bytes
+};
+
+// A compiled script mapped into memory
+// The words of the instructions point directly into the mapping, which is private to the program.
+struct Bytecode {
+	char *data; // The mapped file
+	size_t size; // The size of the mapped file
+	const struct BytecodeHeader *header;
+	const uint32_t *pageIndex;
+	const uint32_t *stringTable;
+	const uint32_t *instructions;
+	char *stringData;
+};
+
+int isBytecodeFile(char *filename);
+int compileScript(char *source, char *target);
+struct Bytecode *mapBytecode(char *filename, int *error);
+void unmapBytecode(struct Bytecode *bc);
+uint32_t firstInstruction(struct Bytecode *bc, int page);
+int decodeInstruction(struct Bytecode *bc, uint32_t *position, char *words[], int *newline);
+int formatInstruction(struct Bytecode *bc, uint32_t *position, char *buffer, int size, int lastOfPage);
+
+#endif
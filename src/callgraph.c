@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file analyses the calls between scripts before the 'run', 'exec' and 'spawn' commands execute them
+// The call graph of the scripts is built from their 'run', 'exec' and 'spawn' instructions. Since scripts have no
+// conditions, every call made before the first 'quit' instruction of a script always happens, so a cycle of 'run'
+// calls never ends: it is reported before any script is executed, instead of when the script stack overflows.
+// A cycle that goes through 'exec' always ends, since a process started by 'exec' cannot use 'exec' again.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "callgraph.h"
+#include "cpu.h" // For INSTRUCTION_SIZE
+#include "bytecode.h"
+#include "scriptreader.h"
+
+enum {
+	UNVISITED = 0, // The script has not been searched
+	VISITING = 1, // The script is on the current chain of 'run' calls
+	VISITED = 2 // The script and the scripts it runs have been searched
+};
+
+KERNEL_STATE struct ScriptNode callGraph[CALL_GRAPH_CACHE_SIZE]; // The calls of the scripts scanned so far
+KERNEL_STATE int nextEviction = 0; // The node that is replaced next when every node is used
+
+// Frees the calls of node
+void clearCalls(struct ScriptNode *node) {
+	struct ScriptCall *call = node->calls;
+	while (call != NULL) {
+		struct ScriptCall *next = call->next;
+		free(call->name);
+		free(call);
+		call = next;
+	}
+	node->calls = NULL;
+}
+
+// Adds a call of the script name of type type to the end of a list of calls, whose last link is *tail
+void addCall(struct ScriptCall ***tail, char *name, int type) {
+	struct ScriptCall *call = (struct ScriptCall *) malloc(sizeof(struct ScriptCall));
+	call->name = strdup(name);
+	call->type = type;
+	call->next = NULL;
+	**tail = call;
+	*tail = &call->next;
+}
+
+// Adds the calls made by the instruction words, interpreted like interpreter() does
+// Returns 1 if the instruction is 'quit', after which the script makes no more calls, and 0 otherwise
+int scanInstruction(char *words[], struct ScriptCall ***tail) {
+	if (words[0] == NULL) {
+		return 0;
+	}
+
+	int last = 0;
+	while (words[last + 1] != NULL) {
+		last++;
+	}
+	int background = last > 0 && strcmp(words[last], "&") == 0;
+	int count = background ? last - 1 : last; // The number of parameters
+
+	if (strcmp(words[0], "quit") == 0 && count == 0) {
+		return 1;
+	} else if (strcmp(words[0], "run") == 0 && count == 1) {
+		addCall(tail, words[1], background ? CALL_PROCESS : CALL_RUN);
+	} else if (strcmp(words[0], "exec") == 0 && count >= 1 && count <= 3) {
+		int i;
+		for (i = 1; i <= count; i++) {
+			addCall(tail, words[i], CALL_PROCESS);
+		}
+	} else if (strcmp(words[0], "spawn") == 0 && count == 2) {
+		addCall(tail, words[2], CALL_PROCESS);
+	}
+
+	return 0;
+}
+
+// Scans the calls of the script filename into node
+void scanCalls(struct ScriptNode *node, char *filename) {
+	struct ScriptCall **tail = &node->calls;
+	char *words[INSTRUCTION_SIZE];
+
+	if (isBytecodeFile(filename)) {
+		int error;
+		struct Bytecode *bc = mapBytecode(filename, &error);
+		if (bc == NULL) {
+			return;
+		}
+
+		uint32_t position = 0;
+		int newline;
+		uint32_t i;
+		for (i = 0; i < bc->header->lineCount; i++) {
+			decodeInstruction(bc, &position, words, &newline);
+			if (scanInstruction(words, &tail)) {
+				break;
+			}
+		}
+		unmapBytecode(bc);
+		return;
+	}
+
+	struct ScriptReader reader;
+	if (openScriptReader(&reader, filename) != 0) {
+		return;
+	}
+
+	// The lines are read and split into words like runCommand() and parse() do
+	char *line;
+	int newline;
+	while ((line = readScriptLine(&reader, &newline)) != NULL) {
+		int i = 0;
+		char *state;
+		words[i] = strtok_r(line, " ", &state);
+		while (words[i] != NULL && i < INSTRUCTION_SIZE - 2) {
+			words[++i] = strtok_r(NULL, " ", &state);
+		}
+
+		if (scanInstruction(words, &tail)) {
+			break;
+		}
+	}
+	closeScriptReader(&reader);
+}
+
+// Finds the node of the script filename, scanning the script if it is new or has changed since it was scanned
+// A node that is part of the analysis in progress is never replaced.
+// Returns the index of the node, or -1 if the script does not exist or no node is available
+int findScriptNode(char *filename) {
+	struct stat info;
+	if (stat(filename, &info) != 0) {
+		return -1;
+	}
+
+	int slot = -1;
+	int i;
+	for (i = 0; i < CALL_GRAPH_CACHE_SIZE; i++) {
+		struct ScriptNode *node = &callGraph[i];
+		if (!node->used) {
+			if (slot == -1) {
+				slot = i;
+			}
+		} else if (node->device == info.st_dev && node->inode == info.st_ino) {
+			if (node->modified != info.st_mtime || node->size != info.st_size) {
+				clearCalls(node);
+				node->modified = info.st_mtime;
+				node->size = info.st_size;
+				scanCalls(node, filename);
+			}
+			return i;
+		}
+	}
+
+	for (i = 0; slot == -1 && i < CALL_GRAPH_CACHE_SIZE; i++) {
+		int candidate = (nextEviction + i) % CALL_GRAPH_CACHE_SIZE;
+		if (callGraph[candidate].reached == 0) {
+			slot = candidate;
+			nextEviction = (candidate + 1) % CALL_GRAPH_CACHE_SIZE;
+			clearCalls(&callGraph[slot]);
+		}
+	}
+	if (slot == -1) {
+		return -1;
+	}
+
+	struct ScriptNode *node = &callGraph[slot];
+	node->used = 1;
+	node->device = info.st_dev;
+	node->inode = info.st_ino;
+	node->modified = info.st_mtime;
+	node->size = info.st_size;
+	node->calls = NULL;
+	node->reached = 0;
+	node->visit = UNVISITED;
+	scanCalls(node, filename);
+
+	return slot;
+}
+
+// Searches the 'run' calls from node i for a cycle, following at most CALL_MAX_DEPTH calls
+// path and chain hold the names and the nodes of the scripts on the current chain of calls, and depth is its length.
+// Returns 1 if a cycle is found, in which case it is written into cycle, and 0 otherwise
+int searchRunCalls(int i, char *path[], int chain[], int depth, char *cycle, int size) {
+	callGraph[i].visit = VISITING;
+	chain[depth - 1] = i;
+
+	struct ScriptCall *call;
+	for (call = callGraph[i].calls; call != NULL && depth < CALL_MAX_DEPTH; call = call->next) {
+		if (call->type != CALL_RUN) {
+			continue;
+		}
+
+		int j = findScriptNode(call->name);
+		if (j == -1) {
+			continue;
+		}
+
+		path[depth] = call->name;
+		if (callGraph[j].visit == VISITING) {
+			// The cycle starts where script j entered the chain
+			int start = 0;
+			while (chain[start] != j) {
+				start++;
+			}
+
+			int len = 0;
+			int k;
+			for (k = start; k <= depth && len < size; k++) {
+				len += snprintf(cycle + len, size - len, k == start ? "%s" : " -> %s", path[k]);
+			}
+			return 1;
+		}
+
+		if (callGraph[j].visit == UNVISITED && searchRunCalls(j, path, chain, depth + 1, cycle, size)) {
+			return 1;
+		}
+	}
+
+	callGraph[i].visit = VISITED;
+	return 0;
+}
+
+// Checks whether the scripts names can run themselves endlessly, directly or through other scripts
+// type is CALL_RUN if the scripts are executed by the 'run' command, and CALL_PROCESS if they are started as processes.
+// Returns 1 if a cycle of 'run' calls can be reached from the scripts, in which case it is written into cycle
+// (for example "a.txt -> b.txt -> a.txt"), and 0 otherwise
+int findRunCycle(char *names[], int count, int type, char *cycle, int size) {
+	// Find the scripts that can be reached from names. A script reached through a process cannot start more
+	// processes, so the scripts are reached either without (bit CALL_RUN) or through (bit CALL_PROCESS) a process.
+	int work[2 * CALL_GRAPH_CACHE_SIZE]; // The scripts whose calls must be followed
+	int ways[2 * CALL_GRAPH_CACHE_SIZE]; // How each of them was reached
+	int pending = 0;
+
+	int i;
+	for (i = 0; i < count; i++) {
+		int node = findScriptNode(names[i]);
+		if (node != -1 && !(callGraph[node].reached & (1 << type))) {
+			callGraph[node].reached |= 1 << type;
+			callGraph[node].name = names[i];
+			work[pending] = node;
+			ways[pending++] = type;
+		}
+	}
+
+	while (pending > 0) {
+		pending--;
+		int node = work[pending];
+		int way = ways[pending];
+
+		struct ScriptCall *call;
+		for (call = callGraph[node].calls; call != NULL; call = call->next) {
+			if (call->type == CALL_PROCESS && way == CALL_PROCESS) {
+				continue; // The process would fail to start it
+			}
+
+			int target = findScriptNode(call->name);
+			int targetWay = call->type == CALL_PROCESS ? CALL_PROCESS : way;
+			if (target != -1 && !(callGraph[target].reached & (1 << targetWay))) {
+				if (callGraph[target].reached == 0) {
+					callGraph[target].name = call->name;
+				}
+				callGraph[target].reached |= 1 << targetWay;
+				work[pending] = target;
+				ways[pending++] = targetWay;
+			}
+		}
+	}
+
+	// Search the reached scripts for a cycle of 'run' calls
+	int found = 0;
+	char *path[CALL_MAX_DEPTH];
+	int chain[CALL_MAX_DEPTH];
+	for (i = 0; i < CALL_GRAPH_CACHE_SIZE && !found; i++) {
+		if (callGraph[i].reached != 0 && callGraph[i].visit == UNVISITED) {
+			path[0] = callGraph[i].name;
+			found = searchRunCalls(i, path, chain, 1, cycle, size);
+		}
+	}
+
+	for (i = 0; i < CALL_GRAPH_CACHE_SIZE; i++) {
+		callGraph[i].reached = 0;
+		callGraph[i].visit = UNVISITED;
+		callGraph[i].name = NULL;
+	}
+
+	return found;
+}
+
+// Forgets the calls of every script
+void clearCallGraph() {
+	int i;
+	for (i = 0; i < CALL_GRAPH_CACHE_SIZE; i++) {
+		clearCalls(&callGraph[i]);
+		callGraph[i].used = 0;
+	}
+}
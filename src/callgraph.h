@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <sys/types.h>
+#include <time.h>
+
+#include "state.h" // For KERNEL_STATE
+
+enum {
+	CALL_GRAPH_CACHE_SIZE = 128, // The number of scripts whose calls can be remembered
+	CALL_MAX_DEPTH = 200, // The longest chain of 'run' calls that is followed, as deep as the script stack
+	CALL_RUN = 0, // A 'run' call, which executes the script inside its caller
+	CALL_PROCESS = 1 // An 'exec', 'spawn' or 'run ... &' call, which starts the script as a process
+};
+
+// A call of a script by another script
+struct ScriptCall {
+	char *name; // The file name of the script called
+	int type; // CALL_RUN or CALL_PROCESS
+	struct ScriptCall *next;
+};
+
+// The calls of a script file, remembered until the file changes
+// A file is identified by its device and inode, so the names that refer to it share the same node.
+struct ScriptNode {
+	int used; // 1 if the node describes a file
+	dev_t device;
+	ino_t inode;
+	time_t modified; // The modification time of the file when it was scanned
+	off_t size; // The size of the file when it was scanned
+	struct ScriptCall *calls; // The calls made before the first 'quit' instruction of the script
+	char *name; // The name by which the analysis in progress first reached the script
+	int reached; // The ways the script is reached by the analysis in progress: bit CALL_RUN and bit CALL_PROCESS
+	int visit; // The state of the script in the search for cycles of 'run' calls
+};
+
+extern KERNEL_STATE struct ScriptNode callGraph[CALL_GRAPH_CACHE_SIZE];
+
+int findRunCycle(char *names[], int count, int type, char *cycle, int size);
+void clearCallGraph();
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements channels, which let the processes executed with 'exec' pass messages to each other
+// A process that receives from an empty channel (or sends to a full one) is blocked: it leaves the
+// ready queue until another process or the user sends to (or receives from) the channel.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "channel.h"
+#include "kernel.h"
+
+KERNEL_STATE struct Channel channels[CHANNEL_COUNT] = { 0 }; // The channels, which are created the first time they are used
+
+// Empties ring and makes its slots available for the first lap
+void initRing(struct Ring *ring) {
+	size_t i;
+	for (i = 0; i < CHANNEL_CAPACITY; i++) {
+		atomic_store_explicit(&ring->slots[i].sequence, i, memory_order_relaxed);
+		ring->slots[i].value = NULL;
+	}
+
+	atomic_store_explicit(&ring->enqueuePosition, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->dequeuePosition, 0, memory_order_relaxed);
+}
+
+// Adds value to the end of ring
+// Returns 0 if value was added, and -1 if ring is full
+int ringPush(struct Ring *ring, char *value) {
+	size_t position = atomic_load_explicit(&ring->enqueuePosition, memory_order_relaxed);
+	struct RingSlot *slot;
+
+	while (1) {
+		slot = &ring->slots[position & (CHANNEL_CAPACITY - 1)];
+		size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+		if (difference == 0) { // The slot is free: try to claim it
+			if (atomic_compare_exchange_weak_explicit(&ring->enqueuePosition, &position, position + 1,
+					memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if (difference < 0) { // The slot still holds the message from the previous lap
+			return -1;
+		} else { // Another producer claimed the slot first
+			position = atomic_load_explicit(&ring->enqueuePosition, memory_order_relaxed);
+		}
+	}
+
+	slot->value = value;
+	atomic_store_explicit(&slot->sequence, position + 1, memory_order_release); // Publish the message
+	return 0;
+}
+
+// Removes the value at the front of ring
+// Returns the value, or NULL if ring is empty
+char *ringPop(struct Ring *ring) {
+	size_t position = atomic_load_explicit(&ring->dequeuePosition, memory_order_relaxed);
+	struct RingSlot *slot;
+
+	while (1) {
+		slot = &ring->slots[position & (CHANNEL_CAPACITY - 1)];
+		size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+		if (difference == 0) { // The slot holds a message: try to claim it
+			if (atomic_compare_exchange_weak_explicit(&ring->dequeuePosition, &position, position + 1,
+					memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if (difference < 0) { // No message has been published in the slot yet
+			return NULL;
+		} else { // Another consumer claimed the slot first
+			position = atomic_load_explicit(&ring->dequeuePosition, memory_order_relaxed);
+		}
+	}
+
+	char *value = slot->value;
+	slot->value = NULL;
+	atomic_store_explicit(&slot->sequence, position + CHANNEL_CAPACITY, memory_order_release); // Free the slot for the next lap
+	return value;
+}
+
+// Returns the index of the channel with the given name
+// If there is no such channel and create is 1, the channel is created
+// Returns NO_CHANNEL if the channel does not exist and could not be created
+int findChannel(char *name, int create) {
+	int i, unused = NO_CHANNEL;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		if (channels[i].name == NULL) {
+			if (unused == NO_CHANNEL) {
+				unused = i;
+			}
+		} else if (strcmp(channels[i].name, name) == 0) {
+			return i;
+		}
+	}
+
+	if (!create || unused == NO_CHANNEL) {
+		return NO_CHANNEL;
+	}
+
+	channels[unused].name = strdup(name);
+	initRing(&channels[unused].ring);
+	channels[unused].waitHead = NULL;
+	channels[unused].waitTail = NULL;
+	return unused;
+}
+
+// Moves the process that has waited the longest for channel back to the ready queue, if any
+// The process executes its 'send' or 'recv' instruction again when it is dispatched.
+void wakeOne(int channel) {
+	struct ReadyQueue *rq = channels[channel].waitHead;
+	if (rq == NULL) {
+		return;
+	}
+
+	channels[channel].waitHead = rq->next;
+	if (channels[channel].waitHead == NULL) {
+		channels[channel].waitTail = NULL;
+	}
+
+	addRQToReady(rq);
+}
+
+// Sends a copy of value to channel
+// Returns 0 if the message was sent, and -1 if the channel is full
+int sendMessage(int channel, char *value) {
+	char *copy = strdup(value);
+	if (ringPush(&channels[channel].ring, copy) != 0) {
+		free(copy);
+		return -1;
+	}
+
+	wakeOne(channel);
+	return 0;
+}
+
+// Receives the oldest message of channel
+// Returns the message, which must be freed by the caller, or NULL if the channel is empty
+char *receiveMessage(int channel) {
+	char *value = ringPop(&channels[channel].ring);
+	if (value != NULL) {
+		wakeOne(channel);
+	}
+
+	return value;
+}
+
+// Returns the number of messages waiting in channel
+int countMessages(int channel) {
+	struct Ring *ring = &channels[channel].ring;
+	return (int) (atomic_load(&ring->enqueuePosition) - atomic_load(&ring->dequeuePosition));
+}
+
+// Returns message i of channel, where message 0 is the oldest, without receiving it
+// This must only be used while no other thread uses the channel
+char *peekMessage(int channel, int i) {
+	struct Ring *ring = &channels[channel].ring;
+	size_t position = atomic_load(&ring->dequeuePosition) + i;
+	return ring->slots[position & (CHANNEL_CAPACITY - 1)].value;
+}
+
+// Parks the ready queue node rq in the wait queue of channel
+void blockOnChannel(int channel, struct ReadyQueue *rq) {
+	rq->next = NULL;
+	if (channels[channel].waitHead == NULL) {
+		channels[channel].waitHead = rq;
+	} else {
+		channels[channel].waitTail->next = rq;
+	}
+	channels[channel].waitTail = rq;
+}
+
+// Counts the processes blocked on every channel
+int countBlocked() {
+	int count = 0;
+	int i;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		struct ReadyQueue *node;
+		for (node = channels[i].waitHead; node != NULL; node = node->next) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+// Moves every blocked process back to the ready queue
+void unblockAll() {
+	int i;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		while (channels[i].waitHead != NULL) {
+			wakeOne(i);
+		}
+	}
+}
+
+// Deletes every channel and the messages it holds
+// The blocked processes must have been unblocked first
+void clearChannels() {
+	int i;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		if (channels[i].name == NULL) {
+			continue;
+		}
+
+		char *value;
+		while ((value = ringPop(&channels[i].ring)) != NULL) {
+			free(value);
+		}
+
+		free(channels[i].name);
+		channels[i].name = NULL;
+	}
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "cpu.h" // For struct ReadyQueue
+
+enum {
+	CHANNEL_COUNT = 10, // The maximum number of channels
+	CHANNEL_CAPACITY = 8, // The number of messages a channel can hold. This must be a power of two.
+	NO_CHANNEL = -1 // Refers to no channel, in functions that return a channel index
+};
+
+// A slot of a ring buffer
+// sequence tells the producers and consumers whether the slot is free or holds a message for the current lap of the ring
+struct RingSlot {
+	atomic_size_t sequence;
+	char *value;
+};
+
+// A bounded multi-producer multi-consumer ring buffer that does not use locks
+// Producers and consumers claim a slot by advancing their position with a compare-and-swap,
+// so any number of them can use the ring at the same time (including a single producer and consumer).
+struct Ring {
+	struct RingSlot slots[CHANNEL_CAPACITY];
+	atomic_size_t enqueuePosition; // The position of the next message to send
+	atomic_size_t dequeuePosition; // The position of the next message to receive
+};
+
+// A named channel through which processes send messages to each other
+// The processes waiting for the channel (to receive from it while it is empty, or to send to it while
+// it is full) are parked in its wait queue instead of the ready queue.
+struct Channel {
+	char *name; // The name of the channel, or NULL if the channel is not used
+	struct Ring ring; // The messages that have been sent but not received
+	struct ReadyQueue *waitHead, *waitTail; // The processes blocked on the channel
+};
+
+extern KERNEL_STATE struct Channel channels[CHANNEL_COUNT];
+
+int findChannel(char *name, int create);
+int sendMessage(int channel, char *value);
+char *receiveMessage(int channel);
+int countMessages(int channel);
+char *peekMessage(int channel, int i);
+void blockOnChannel(int channel, struct ReadyQueue *rq);
+int countBlocked();
+void unblockAll();
+void clearChannels();
+
+#endif
@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file saves the state of the kernel to a checkpoint file and restores it
+//
+// A checkpoint is a binary image made of the following sections, in order:
+// - The header: CHECKPOINT_MAGIC followed by CHECKPOINT_VERSION
+// - The process and image counters, and the image cache
+// - The frame table and the contents of every cell of RAM
+// - The PCBs, in the order in which they will be executed (blocked, suspended and sleeping PCBs last)
+// - The variables in shell memory
+// - The channels and their messages
+// - The page files in the backing store
+// Integers are stored as 32-bit or 64-bit values in the byte order of the machine, and strings are
+// stored as a 32-bit length followed by their characters (a length of -1 represents NULL).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+#include "cpu.h"
+#include "kernel.h"
+#include "memorymanager.h"
+#include "shellmemory.h"
+#include "channel.h"
+#include "arena.h"
+#include "timer.h"
+
+const char CHECKPOINT_MAGIC[8] = "MYKCKPT"; // Identifies a checkpoint file
+enum {
+	CHECKPOINT_VERSION = 2, // The version of the checkpoint format
+	PATH_SIZE = BACKING_STORE_SIZE + 300 // The buffer size for the path of a page file
+};
+
+// Writes a 32-bit integer to the checkpoint file f
+void writeInt(FILE *f, int32_t i) {
+	fwrite(&i, sizeof(i), 1, f);
+}
+
+// Writes a 64-bit integer to the checkpoint file f
+void writeLong(FILE *f, int64_t l) {
+	fwrite(&l, sizeof(l), 1, f);
+}
+
+// Writes a string of length len to the checkpoint file f
+void writeBytes(FILE *f, const char *str, int32_t len) {
+	writeInt(f, len);
+	if (len > 0) {
+		fwrite(str, 1, len, f);
+	}
+}
+
+// Writes a string, or NULL, to the checkpoint file f
+void writeString(FILE *f, const char *str) {
+	writeBytes(f, str, str == NULL ? -1 : (int32_t) strlen(str));
+}
+
+// Writes a PCB to the checkpoint file f
+void writePCB(FILE *f, struct PCB *pcb, int PC_offset) {
+	writeInt(f, pcb->PID);
+	writeInt(f, pcb->PC_page);
+	writeInt(f, PC_offset);
+	writeInt(f, pcb->pages_max);
+	writeInt(f, pcb->image);
+
+	int i;
+	for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+		writeInt(f, pcb->pageTable[i]);
+	}
+}
+
+// Writes the PCB of a process that is not admitted yet to the checkpoint file f
+// None of its pages are in RAM, so it is restored as a process that has not started.
+void writePendingLaunch(FILE *f, struct LaunchRequest *request) {
+	writeInt(f, request->PID);
+	writeInt(f, 0);
+	writeInt(f, 0);
+	writeInt(f, request->pages_max);
+	writeInt(f, request->image);
+
+	int i;
+	for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+		writeInt(f, -1);
+	}
+}
+
+// Writes every page file in the backing store to the checkpoint file f
+int writeBackingStore(FILE *f) {
+	DIR *dir = opendir(backingStore);
+	if (dir == NULL) {
+		return -1;
+	}
+
+	// Count the page files first, since the count precedes them
+	int count = 0;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (entry->d_name[0] != '.') {
+			count++;
+		}
+	}
+
+	writeInt(f, count);
+	rewinddir(dir);
+
+	char path[PATH_SIZE];
+	while ((entry = readdir(dir)) != NULL && count > 0) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+
+		snprintf(path, PATH_SIZE, "%s/%s", backingStore, entry->d_name);
+		FILE *page = fopen(path, "r");
+		struct stat st;
+		if (page == NULL || fstat(fileno(page), &st) == -1) {
+			break;
+		}
+
+		char *buffer = (char *) malloc(st.st_size + 1);
+		int len = (int) fread(buffer, 1, st.st_size, page);
+		fclose(page);
+
+		writeString(f, entry->d_name);
+		writeBytes(f, buffer, len);
+		free(buffer);
+		count--;
+	}
+
+	closedir(dir);
+	return count == 0 ? 0 : -1;
+}
+
+// Saves the state of the kernel to the file filename
+// Returns 0 if the checkpoint was saved, and -1 if the file could not be written
+int saveCheckpoint(char *filename) {
+	FILE *f = fopen(filename, "wb");
+	if (f == NULL) {
+		return -1;
+	}
+
+	waitForLaunchImages(); // Processes that are not admitted yet are saved with the pages of their images
+	materializeImages(); // The pages of compiled scripts are saved with the backing store
+
+	fwrite(CHECKPOINT_MAGIC, 1, sizeof(CHECKPOINT_MAGIC), f);
+	writeInt(f, CHECKPOINT_VERSION);
+
+	// Counters and image cache
+	writeInt(f, lastPID);
+	writeInt(f, lastImage);
+	writeInt(f, imageCacheCount);
+	int i;
+	for (i = 0; i < imageCacheCount; i++) {
+		writeLong(f, (int64_t) imageCache[i].hash);
+		writeLong(f, imageCache[i].size);
+		writeInt(f, imageCache[i].image);
+	}
+
+	// Frames
+	for (i = 0; i < FRAME_COUNT; i++) {
+		writeInt(f, frameTable[i].image);
+		writeInt(f, frameTable[i].page);
+		writeInt(f, frameTable[i].refs);
+	}
+
+	for (i = 0; i < RAM_SIZE; i++) {
+		writeString(f, ram[i]);
+	}
+
+	// PCBs: the running PCB (if the checkpoint is taken by a script) resumes first, after the 'checkpoint' instruction
+	int count = runningPCB != NULL ? 1 : 0;
+	struct ReadyQueue *node;
+	for (node = head; node != NULL; node = node->next) {
+		count++;
+	}
+	for (node = suspendedHead; node != NULL; node = node->next) {
+		count++;
+	}
+	count += countBlocked() + timerWheel.count;
+	for (i = admittedLaunches; i < pendingLaunchCount; i++) {
+		count += pendingLaunches[i].killed ? 0 : 1;
+	}
+
+	writeInt(f, count);
+	if (runningPCB != NULL) {
+		writePCB(f, runningPCB, cpu.offset + 1);
+	}
+	for (node = head; node != NULL; node = node->next) {
+		writePCB(f, node->pcb, node->pcb->PC_offset);
+	}
+	for (i = admittedLaunches; i < pendingLaunchCount; i++) { // They would be admitted at the end of the quantum
+		if (!pendingLaunches[i].killed) {
+			writePendingLaunch(f, &pendingLaunches[i]);
+		}
+	}
+	for (i = 0; i < CHANNEL_COUNT; i++) { // Blocked PCBs are restored as ready, and execute their 'send' or 'recv' instruction again
+		for (node = channels[i].waitHead; node != NULL; node = node->next) {
+			writePCB(f, node->pcb, node->pcb->PC_offset);
+		}
+	}
+	for (node = suspendedHead; node != NULL; node = node->next) { // Suspended PCBs are restored as ready
+		writePCB(f, node->pcb, node->pcb->PC_offset);
+	}
+	int level, slot;
+	for (level = 0; level < TIMER_LEVELS; level++) { // Sleeping PCBs are restored as ready, after their 'sleep' instruction
+		for (slot = 0; slot < TIMER_SLOTS; slot++) {
+			for (node = timerWheel.slots[level][slot].head; node != NULL; node = node->next) {
+				writePCB(f, node->pcb, node->pcb->PC_offset);
+			}
+		}
+	}
+
+	// Shell memory
+	count = 0;
+	while (NameOfVarAt(count) != NULL) {
+		count++;
+	}
+
+	writeInt(f, count);
+	for (i = 0; i < count; i++) {
+		writeString(f, NameOfVarAt(i));
+		writeString(f, ValueOfVar(NameOfVarAt(i)));
+	}
+
+	// Channels
+	count = 0;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		if (channels[i].name != NULL) {
+			count++;
+		}
+	}
+
+	writeInt(f, count);
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		if (channels[i].name == NULL) {
+			continue;
+		}
+
+		writeString(f, channels[i].name);
+		int messages = countMessages(i);
+		writeInt(f, messages);
+		int j;
+		for (j = 0; j < messages; j++) {
+			writeString(f, peekMessage(i, j));
+		}
+	}
+
+	// Backing store
+	int error = writeBackingStore(f);
+
+	if (ferror(f)) {
+		error = -1;
+	}
+
+	if (fclose(f) != 0) {
+		error = -1;
+	}
+
+	return error;
+}
+
+// A cursor over a checkpoint image mapped into memory
+struct CheckpointReader {
+	const char *data; // The mapped image
+	size_t size; // The size of the image
+	size_t position; // The position of the next value to read
+	int error; // Set to 1 when a read goes past the end of the image
+};
+
+// Reads a 32-bit integer from the checkpoint image
+int32_t readInt(struct CheckpointReader *r) {
+	int32_t i = 0;
+	if (r->error || r->size - r->position < sizeof(i)) {
+		r->error = 1;
+		return 0;
+	}
+
+	memcpy(&i, r->data + r->position, sizeof(i));
+	r->position += sizeof(i);
+	return i;
+}
+
+// Reads a 64-bit integer from the checkpoint image
+int64_t readLong(struct CheckpointReader *r) {
+	int64_t l = 0;
+	if (r->error || r->size - r->position < sizeof(l)) {
+		r->error = 1;
+		return 0;
+	}
+
+	memcpy(&l, r->data + r->position, sizeof(l));
+	r->position += sizeof(l);
+	return l;
+}
+
+// Reads a string from the checkpoint image without copying it
+// Returns a pointer into the image and stores the length of the string in len (-1 for NULL)
+const char *readBytes(struct CheckpointReader *r, int32_t *len) {
+	*len = readInt(r);
+	if (r->error || *len < 0) {
+		return NULL;
+	}
+
+	if (r->size - r->position < (size_t) *len) {
+		r->error = 1;
+		*len = -1;
+		return NULL;
+	}
+
+	const char *str = r->data + r->position;
+	r->position += *len;
+	return str;
+}
+
+// Reads a string from the checkpoint image into a newly allocated string, or NULL
+char *readString(struct CheckpointReader *r) {
+	int32_t len;
+	const char *str = readBytes(r, &len);
+	if (str == NULL) { // NULL, or past the end of the image
+		return NULL;
+	}
+
+	char *copy = (char *) malloc(len + 1);
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+// Restores the state of the kernel from the checkpoint image in r
+// The current state of the kernel must have been cleared
+int restoreFrom(struct CheckpointReader *r) {
+	if (r->size < sizeof(CHECKPOINT_MAGIC) || memcmp(r->data, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+		return -2; // Not a checkpoint
+	}
+
+	r->position = sizeof(CHECKPOINT_MAGIC);
+	if (readInt(r) != CHECKPOINT_VERSION) {
+		return -2;
+	}
+
+	// Counters and image cache
+	lastPID = readInt(r);
+	lastImage = readInt(r);
+	int count = readInt(r);
+	if (count < 0 || count > IMAGE_CACHE_SIZE) {
+		return -2;
+	}
+
+	int i;
+	for (i = 0; i < count && !r->error; i++) {
+		imageCache[i].hash = (unsigned long) readLong(r);
+		imageCache[i].size = readLong(r);
+		imageCache[i].image = readInt(r);
+		imageCache[i].bytecode = NULL;
+	}
+	imageCacheCount = count;
+
+	// Frames
+	for (i = 0; i < FRAME_COUNT; i++) {
+		frameTable[i].image = readInt(r);
+		frameTable[i].page = readInt(r);
+		frameTable[i].refs = readInt(r);
+
+		// A free frame holds no page, and a loaded frame holds a page of its image
+		int page = frameTable[i].page;
+		int validPage = frameTable[i].image == FREE_FRAME ? page == -1 : page >= 0 && page < RAM_SIZE / PAGE_SIZE;
+		if (!validPage || frameTable[i].refs < 0) {
+			return -2;
+		}
+	}
+
+	for (i = 0; i < RAM_SIZE && !r->error; i++) {
+		char *line = readString(r);
+		setRamLine(i, line);
+		free(line);
+	}
+
+	// PCBs
+	count = readInt(r);
+	for (i = 0; i < count && !r->error; i++) {
+		int PID = readInt(r);
+		int PC_page = readInt(r);
+		int PC_offset = readInt(r);
+		int pages_max = readInt(r);
+		int image = readInt(r);
+		int pageTable[RAM_SIZE / PAGE_SIZE];
+
+		// The program counter must be in the script, and a page must be mapped to a frame that holds it
+		int valid = 0 <= PC_page && PC_page < pages_max && pages_max <= RAM_SIZE / PAGE_SIZE;
+		valid = valid && 0 <= PC_offset && PC_offset <= PAGE_SIZE && 1 <= image && image <= lastImage;
+		int j;
+		for (j = 0; j < RAM_SIZE / PAGE_SIZE; j++) {
+			int frame = readInt(r);
+			pageTable[j] = frame;
+			if (frame != -1 && (frame < 0 || frame >= FRAME_COUNT || frameTable[frame].image != image || frameTable[frame].page != j)) {
+				valid = 0;
+			}
+		}
+
+		if (!valid || r->error) {
+			r->error = 1;
+			break;
+		}
+
+		struct PCB *pcb = initPCB(PID, pages_max);
+		pcb->PC_page = PC_page;
+		pcb->PC_offset = PC_offset;
+		pcb->image = image;
+		memcpy(pcb->pageTable, pageTable, sizeof(pageTable));
+	}
+
+	// The reference count of a frame is the number of page tables that map it
+	for (i = 0; i < FRAME_COUNT; i++) {
+		frameTable[i].refs = 0;
+	}
+	struct PCB *pcb;
+	for (pcb = processList; pcb != NULL; pcb = pcb->nextProcess) {
+		int j;
+		for (j = 0; j < RAM_SIZE / PAGE_SIZE; j++) {
+			if (pcb->pageTable[j] != -1) {
+				frameTable[pcb->pageTable[j]].refs++;
+			}
+		}
+	}
+
+	// Shell memory
+	count = readInt(r);
+	for (i = 0; i < count && !r->error; i++) {
+		char *var = readString(r);
+		char *value = readString(r);
+		if (var != NULL && value != NULL) {
+			setVar(var, value);
+		}
+		free(var);
+		free(value);
+	}
+
+	// Channels
+	count = readInt(r);
+	if (count < 0 || count > CHANNEL_COUNT) {
+		return -2;
+	}
+
+	for (i = 0; i < count && !r->error; i++) {
+		char *name = readString(r);
+		int messages = readInt(r);
+		if (name == NULL || messages < 0 || messages > CHANNEL_CAPACITY) {
+			free(name);
+			return -2;
+		}
+
+		int channel = findChannel(name, 1);
+		free(name);
+
+		int j;
+		for (j = 0; j < messages && !r->error; j++) {
+			char *value = readString(r);
+			if (value != NULL) {
+				sendMessage(channel, value);
+			}
+			free(value);
+		}
+	}
+
+	// Backing store
+	count = readInt(r);
+	char path[PATH_SIZE];
+	for (i = 0; i < count && !r->error; i++) {
+		int32_t nameLen, len;
+		const char *name = readBytes(r, &nameLen);
+		const char *contents = readBytes(r, &len);
+		if (r->error || name == NULL || nameLen >= PATH_SIZE / 2 || memchr(name, '/', nameLen) != NULL) {
+			return -2;
+		}
+
+		snprintf(path, PATH_SIZE, "%s/%.*s", backingStore, (int) nameLen, name);
+		FILE *page = fopen(path, "w");
+		if (page == NULL) {
+			return -1;
+		}
+		if (len > 0) {
+			fwrite(contents, 1, len, page);
+		}
+		fclose(page);
+	}
+
+	// Every page of the restored processes must be in the backing store
+	for (pcb = processList; pcb != NULL && !r->error; pcb = pcb->nextProcess) {
+		int j;
+		for (j = 0; j < pcb->pages_max; j++) {
+			snprintf(path, PATH_SIZE, "%s/%d.%d.txt", backingStore, pcb->image, j);
+			if (access(path, R_OK) != 0) {
+				r->error = 1;
+				break;
+			}
+		}
+	}
+
+	return r->error ? -2 : 0;
+}
+
+// Restores the state of the kernel from the file filename
+// The RAM, the ready queue, the shell memory and the backing store are replaced by the contents of the checkpoint.
+// Returns 0 if the checkpoint was restored, -1 if the file could not be read, and -2 if the file is not a valid checkpoint.
+// If -2 is returned, the kernel is left with empty RAM, ready queue and backing store.
+int restoreCheckpoint(char *filename) {
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		return -1;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return -2; // An empty file is not a checkpoint
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return -1;
+	}
+
+	// Clear the current state of the kernel
+	unmapImages();
+	clearRam();
+	clearReadyQueue();
+	resetArena(&sessionArena);
+	clearShellMemory();
+	clearChannels();
+	resetBackingStore();
+
+	struct CheckpointReader r = { .data = (const char *) data, .size = st.st_size, .position = 0, .error = 0 };
+	int error = restoreFrom(&r);
+
+	munmap(data, st.st_size);
+
+	if (error != 0) {
+		unmapImages();
+		clearRam();
+		clearReadyQueue();
+		resetArena(&sessionArena);
+		resetBackingStore();
+	}
+
+	return error;
+}
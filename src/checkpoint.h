@@ -0,0 +1,11 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+int saveCheckpoint(char *filename);
+int restoreCheckpoint(char *filename);
+
+#endif
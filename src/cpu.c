@@ -11,12 +11,35 @@
 #include "interpreter.h"
 #include "shell.h"
 #include "pcb.h"
+#include "tlb.h"
+#include "kernel.h"
+#include "channel.h"
+#include "probe.h"
+#include "timer.h"
 
 // Initialize cpu
-struct CPU cpu = {.IP = 0, .offset = 0, .IR = { '\0' }, .quanta = QUANTA};
+KERNEL_STATE struct CPU cpu = {.IP = 0, .offset = 0, .IR = { '\0' }, .quanta = QUANTA, .waitChannel = -1, .sleepTicks = 0};
+KERNEL_STATE struct ReadyQueue *head = NULL, *tail = NULL; // The head and tail of the ready queue
+
+// Translates page of PCB pcb into the index of the frame that holds it, or -1 if the page is not in RAM
+// The TLB is consulted first, and the page table is only read on a TLB miss
+int translate(struct PCB *pcb, int page) {
+	switchTLBContext(pcb->PID);
+
+	int frame = lookupTLB(pcb->PID, page);
+	if (frame == -1) {
+		frame = pcb->pageTable[page];
+		if (frame != -1) {
+			insertTLB(pcb->PID, page, frame);
+		}
+	}
+
+	return frame;
+}
 
 // Runs quanta instructions from RAM
 int run(int quanta) {
+	PROBE(PROBE_RUN);
 	int i; // For loop counter
 	int done = 0; // When this is 1, the function terminates
 	
@@ -37,6 +60,15 @@ int run(int quanta) {
 		// Execute the instruction
 		parse(cpu.IR);
 
+		if (cpu.waitChannel != -1) { // The instruction is blocked on a channel
+			return 2; // Generate pseudo-interrupt without moving past the instruction, which is executed again once the process is unblocked
+		}
+
+		if (cpu.sleepTicks > 0) { // The instruction put the process to sleep
+			cpu.offset++;
+			return 3; // Generate pseudo-interrupt after moving past the instruction
+		}
+
 		if (endOfFile) { // Stop executing the script if the end of the file has been reached
 			done = 1;
 		}
@@ -56,19 +88,21 @@ int run(int quanta) {
 	return 0;
 }
 
-// Clears the ready queue
+// Clears the ready queue, including the processes suspended by load control, blocked on a channel or asleep
 void clearReadyQueue() {
+	resumeAllProcesses();
+	unblockAll();
+	wakeAllSleepers();
+
 	while (head != NULL) {
 		if (head == tail) {
-			free(head->pcb);
-			free(head);
+			terminateProcess(head);
 			break;
 		}
 
 		struct ReadyQueue *rq = head;
 		head = head->next;
-		free(rq->pcb);
-		free(rq);
+		terminateProcess(rq);
 	}
 
 	head = NULL;
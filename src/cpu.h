@@ -5,6 +5,8 @@
 #ifndef CPU_H
 #define CPU_H
 
+#include "pcb.h" // For struct PCB
+
 enum {
 	INSTRUCTION_SIZE = 1000, // The maximum number of characters in a single instruction
 	QUANTA = 2 // The number of instructions to execute before a task-switch
@@ -16,6 +18,8 @@ struct CPU {
 	int offset; // The index of the current element in the frame. This is an integer between 0 and PAGE_SIZE - 1.
 	char IR[INSTRUCTION_SIZE]; // Instruction register: the the instruction that will be sent to the interpreter for execution
 	int quanta; // Quanta field
+	int waitChannel; // The channel on which the instruction in IR is blocked, or -1 if it was executed
+	int sleepTicks; // The number of ticks the instruction in IR put the process to sleep for, or 0
 };
 
 // This structure implements a node of the ready queue in a singly-linked list
@@ -25,9 +29,10 @@ struct ReadyQueue {
 	struct ReadyQueue *next;
 };
 
-struct CPU cpu; // The CPU
-struct ReadyQueue *head, *tail; // The head and tail of the ready queue
+extern KERNEL_STATE struct CPU cpu; // The CPU
+extern KERNEL_STATE struct ReadyQueue *head, *tail; // The head and tail of the ready queue
 
+int translate(struct PCB *pcb, int page);
 int run(int quanta);
 void clearReadyQueue();
 
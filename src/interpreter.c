@@ -6,28 +6,42 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "shellmemory.h"
 #include "shell.h"
 #include "cpu.h"
 #include "memorymanager.h"
 #include "kernel.h"
+#include "checkpoint.h"
+#include "tlb.h"
+#include "jobs.h"
+#include "channel.h"
+#include "probe.h"
+#include "bytecode.h"
+#include "arena.h"
+#include "simulator.h"
+#include "trace.h"
+#include "callgraph.h"
+#include "timer.h"
+#include "scriptreader.h"
 
 // Define constants for the script stack
 enum {
 	SCRIPT_STACK_SIZE = 200, // The size of the script stack
 	EMPTY = 0, // The value of an empty element in the script stack
 	EXEC = -1, // This value at the head of the script stack indicates that the last script was executed with the 'exec' command
-	RUN = 1 // This value at the head of the script stack indicates that the last script was executed with the 'run' command
+	RUN = 1, // This value at the head of the script stack indicates that the last script was executed with the 'run' command
+	SPAWN_MAX = 1000 // The maximum number of processes created by the 'spawn' command
 };
 
-int runningScript = 0; // The number of nested 'run' commands being executed: to know if a line being interpreted comes from a script (from the 'run' command) or was typed by the user (in order to interpret the quit command correctly)
-int executingScript = 0; // To know if a line being interpreted comes from a script (from the 'exec' command) or was typed by the user (in order to interpret the quit command correctly)
-int quitRunningScript = 0; // Indicates whether the currently running script (from the 'run' command) needs to quit
-int quitExecutingScript = 0; // Indicates whether the currently running script (from the 'exec' command) needs to quit
-int scriptStack[SCRIPT_STACK_SIZE] = { EMPTY }; // The script stack keeps track of how the last script was executed: -1 means from 'exec' and 1 means from 'run'
-int scriptStackIndex = -1; // The index of the last element of scriptStack
-int mustResetInterpreterVariables = 0; // Indicates whether all of the interpreter variables above need to be reset (which is the case after running the stopAllScripts() method)
+KERNEL_STATE int runningScript = 0; // The number of nested 'run' commands being executed: to know if a line being interpreted comes from a script (from the 'run' command) or was typed by the user (in order to interpret the quit command correctly)
+KERNEL_STATE int executingScript = 0; // To know if a line being interpreted comes from a script (from the 'exec' command) or was typed by the user (in order to interpret the quit command correctly)
+KERNEL_STATE int quitRunningScript = 0; // Indicates whether the currently running script (from the 'run' command) needs to quit
+KERNEL_STATE int quitExecutingScript = 0; // Indicates whether the currently running script (from the 'exec' command) needs to quit
+KERNEL_STATE int scriptStack[SCRIPT_STACK_SIZE] = { EMPTY }; // The script stack keeps track of how the last script was executed: -1 means from 'exec' and 1 means from 'run'
+KERNEL_STATE int scriptStackIndex = -1; // The index of the last element of scriptStack
+KERNEL_STATE int mustResetInterpreterVariables = 0; // Indicates whether all of the interpreter variables above need to be reset (which is the case after running the stopAllScripts() method)
 
 // Pushes integer i to the script stack
 int pushToScriptStack(int i) {
@@ -87,6 +101,25 @@ void help() {
 			"print VAR\t\t\tDisplays the value assigned to variable VAR\n"
 			"run SCRIPT.TXT\t\t\tExecutes the file SCRIPT.TXT\n"
 			"exec S1.TXT S2.TXT S3.TXT\tExecutes up to three files concurrently\n"
+			"spawn N SCRIPT.TXT\t\tExecutes N processes that share the pages of SCRIPT.TXT\n"
+			"run/exec/spawn ... &\t\tExecutes the files in the background as a job\n"
+			"jobs\t\t\t\tDisplays the background jobs\n"
+			"wait [JOB]\t\t\tWaits until a job (or every job) has finished\n"
+			"kill JOB\t\t\tTerminates the processes of a job\n"
+			"compile SCRIPT.TXT\t\tCompiles SCRIPT.TXT into SCRIPT.kbc, which 'run' and 'exec' load faster\n"
+			"send CHAN VALUE\t\t\tSends VALUE to channel CHAN\n"
+			"recv CHAN VAR\t\t\tReceives a message from channel CHAN into variable VAR\n"
+			"sleep N\t\t\t\tPuts the process to sleep for N ticks of the scheduler\n"
+			"checkpoint FILE\t\t\tSaves the state of the kernel to FILE\n"
+			"restore FILE\t\t\tRestores the state of the kernel from FILE\n"
+			"tlb [SIZE WAYS POLICY MODE]\tDisplays the TLB statistics or configures the TLB\n"
+			"vmstat\t\t\t\tDisplays the virtual memory statistics\n"
+			"replacement global|local [N]\tSelects global or local page replacement (with N frames per process)\n"
+			"pagedaemon LOW HIGH|off\t\tKeeps between LOW and HIGH frames free, or stops the page daemon\n"
+			"meminfo\t\t\t\tDisplays the memory used by the processes\n"
+			"runstat\t\t\t\tDisplays the lines read by 'run' and its throughput\n"
+			"trace FILE|off\t\t\tRecords the page references into FILE, or stops recording them\n"
+			"simulate N INSTR PAGES PATTERN\tSimulates N processes of INSTR instructions on PAGES pages\n"
 			);
 }
 
@@ -119,8 +152,7 @@ void set(char* var, char* string) {
 
 // Performs the 'print' command
 void print(char* var) {
-	char *str = (char *) malloc(INSTRUCTION_SIZE * sizeof(char));
-	strcpy(str, ValueOfVar(var));
+	char *str = ValueOfVar(var);
 
 	if (*str != '\0') {
 		printf("%s\n", str);
@@ -129,72 +161,546 @@ void print(char* var) {
 	}
 }
 
+// Stops all scripts being executed by the 'run' and 'exec' commands
+void stopAllScripts() {
+	mustResetInterpreterVariables = 1;
+	clearRam();
+	clearReadyQueue();
+	if (processList == NULL) { // The PCB of the running process (if any) is released when the scheduler terminates it
+		resetArena(&sessionArena);
+	}
+}
+
+// Handles the error of the script stack being full
+void scriptStackIsFullError() {
+	printf("Error: Maximum recursion depth (%d) reached\n", SCRIPT_STACK_SIZE);
+	stopAllScripts();
+}
+
+// Clears the RAM and the ready queue once every process has terminated, which ends the exec session
+// Every PCB, ready queue node and line loaded into RAM during the session is then released at once
+void releaseIdleMemory() {
+	if (processList == NULL) {
+		clearRam();
+		clearReadyQueue();
+		resetArena(&sessionArena);
+	}
+}
+
+// Executes the processes in the ready queue until the job with ID job (or every job of the current owner, if job is ALL_JOBS) has finished
+// The processes of the other jobs are executed at the same time. The RAM is cleared once no process is left.
+void waitForJob(int job) {
+	int deadlocked = runJob(job);
+	if (deadlocked > 0) {
+		printf("Error: Deadlock detected, %d process%s blocked on channels %s terminated\n", deadlocked,
+				deadlocked == 1 ? "" : "es", deadlocked == 1 ? "was" : "were");
+	}
+
+	releaseIdleMemory();
+}
+
+// Performs the 'tlb' command
+// Without parameters, it displays the TLB statistics. Otherwise, it configures the TLB with
+// SIZE entries, WAYS entries per set, the POLICY replacement policy (lru, fifo or random) and
+// the MODE context-switch behaviour (flush or tag)
+int tlbCommand(char *words[]) {
+	if (words[1] == NULL) {
+		printTLB();
+		return 0;
+	}
+
+	int policy, mode;
+	if (words[3] == NULL || words[4] == NULL || words[5] != NULL) {
+		return -1;
+	}
+
+	if (strcmp(words[3], "lru") == 0) {
+		policy = TLB_LRU;
+	} else if (strcmp(words[3], "fifo") == 0) {
+		policy = TLB_FIFO;
+	} else if (strcmp(words[3], "random") == 0) {
+		policy = TLB_RANDOM;
+	} else {
+		return -1;
+	}
+
+	if (strcmp(words[4], "flush") == 0) {
+		mode = TLB_FLUSH;
+	} else if (strcmp(words[4], "tag") == 0) {
+		mode = TLB_TAGGED;
+	} else {
+		return -1;
+	}
+
+	if (configureTLB(atoi(words[1]), atoi(words[2]), policy, mode) != 0) {
+		return -1;
+	}
+
+	printTLB();
+	return 0;
+}
+
+// Displays the page replacement policy
+void printReplacementPolicy() {
+	if (replacementPolicy == GLOBAL_REPLACEMENT) {
+		printf("Page replacement: global\n");
+	} else if (staticQuota > 0) {
+		printf("Page replacement: local, %d frames per process\n", staticQuota);
+	} else {
+		printf("Page replacement: local, frames proportional to script size\n");
+	}
+}
+
+// Displays the watermarks of the page daemon
+void printPageDaemon() {
+	if (lowWatermark == 0) {
+		printf("Page daemon: off\n");
+	} else {
+		printf("Page daemon: reclaims up to %d free frames when fewer than %d are free\n", highWatermark, lowWatermark);
+	}
+}
+
+// Performs the 'vmstat' command
+void vmstat() {
+	printf("Page faults: %ld (%d%% of recent dispatches)\n", vmstats.pageFaults, pageFaultRate());
+	printf("Suspended processes: %d (suspensions: %ld, resumptions: %ld)\n", countSuspended(), vmstats.suspensions, vmstats.resumptions);
+	printReplacementPolicy();
+	printPageDaemon();
+	printf("Reclaimed frames: %ld by page faults, %ld by the page daemon (%ld runs)\n", vmstats.directReclaims,
+			vmstats.daemonReclaims, vmstats.daemonRuns);
+}
+
+// Performs the 'trace' command
+// 'trace FILE' starts recording the page references and the page faults of the kernel into the trace file FILE,
+// which the tracereplay program can replay, and 'trace off' stops recording them
+void traceCommand(char *argument) {
+	if (strcmp(argument, "off") == 0) {
+		long records = stopTrace();
+		if (records == -1) {
+			printf("Error: No trace is being recorded\n");
+		} else {
+			printf("Trace stopped: %ld record%s written\n", records, records == 1 ? "" : "s");
+		}
+	} else if (isTracing()) {
+		printf("Error: A trace is already being recorded\n");
+	} else if (startTrace(argument) != 0) {
+		printf("Error: Trace file '%s' could not be created\n", argument);
+	} else {
+		printf("Recording page references into '%s'\n", argument);
+	}
+}
+
+// Performs the 'meminfo' command
+// Displays the memory used by the exec session, which is allocated from the session arena
+void meminfo() {
+	printf("Session arena: %zu bytes in use, %zu bytes at peak, %zu bytes reserved in %d block%s\n", sessionArena.bytes,
+			sessionArena.peak, sessionArena.reserved, sessionArena.blocks, sessionArena.blocks == 1 ? "" : "s");
+}
+
+// Performs the 'runstat' command
+// Displays the lines read from the scripts executed by 'run', and the rate at which they were read and executed
+void runstat() {
+	printf("Scripts run: %ld (%ld lines, %lld bytes, longest line: %ld characters)\n", scriptStats.scripts,
+			scriptStats.lines, scriptStats.bytes, scriptStats.longestLine);
+	printf("Throughput: %.2f MB/s (%.3f s executing 'run')\n",
+			scriptStats.seconds > 0 ? scriptStats.bytes / scriptStats.seconds / 1e6 : 0.0, scriptStats.seconds);
+}
+
+// Parses word as a number between min and max into value
+// Returns 0, or -1 if word is not such a number
+int parseNumber(char *word, long min, long max, long *value) {
+	char *end;
+	*value = strtol(word, &end, 10);
+	if (end == word || *end != '\0' || *value < min || *value > max) {
+		return -1;
+	}
+
+	return 0;
+}
+
+// Performs the 'simulate' command
+// 'simulate N INSTRUCTIONS PAGES seq|random|local [INTERVAL [LATENCY]]' runs the scheduler and the pager on N synthetic
+// processes that each execute INSTRUCTIONS instructions spread over PAGES pages, with the given page reference pattern.
+// A process arrives every INTERVAL instructions, and a page fault blocks a process for LATENCY instructions.
+// Returns 0, or -1 if the parameters are invalid
+int simulateCommand(char *words[]) {
+	struct Simulation sim = { .interval = 0, .latency = 0 };
+	long pages;
+	if (words[1] == NULL || words[2] == NULL || words[3] == NULL || words[4] == NULL
+			|| (words[5] != NULL && words[6] != NULL && words[7] != NULL)
+			|| parseNumber(words[1], 1, 100000000, &sim.processes) != 0
+			|| parseNumber(words[2], 1, 1000000000, &sim.instructions) != 0
+			|| parseNumber(words[3], 1, RAM_SIZE / PAGE_SIZE, &pages) != 0
+			|| (words[5] != NULL && parseNumber(words[5], 0, 1000000000, &sim.interval) != 0)
+			|| (words[5] != NULL && words[6] != NULL && parseNumber(words[6], 0, 1000000000, &sim.latency) != 0)) {
+		return -1;
+	}
+	sim.pages = pages;
+
+	if (strcmp(words[4], "seq") == 0) {
+		sim.pattern = SIM_SEQUENTIAL;
+	} else if (strcmp(words[4], "random") == 0) {
+		sim.pattern = SIM_RANDOM;
+	} else if (strcmp(words[4], "local") == 0) {
+		sim.pattern = SIM_LOCAL;
+	} else {
+		return -1;
+	}
+
+	int error = simulate(&sim);
+	if (error == -1) {
+		printf("Error: Not enough memory to simulate %ld processes\n", sim.processes);
+	} else if (error == -2) {
+		printf("Error: The simulation stopped because a victim frame could not be found!\n");
+	}
+
+	return 0;
+}
+
+// Performs the 'replacement' command
+// 'replacement global' lets a process take a victim frame from any other process.
+// 'replacement local' gives every process a frame quota proportional to the size of its script, and
+// 'replacement local N' gives every process a quota of N frames; a process that has used up its quota
+// replaces its own pages.
+int replacement(char *mode, char *quota) {
+	if (strcmp(mode, "global") == 0 && quota == NULL) {
+		replacementPolicy = GLOBAL_REPLACEMENT;
+	} else if (strcmp(mode, "local") == 0) {
+		int n = quota == NULL ? 0 : atoi(quota);
+		if (quota != NULL && (n < 1 || n > FRAME_COUNT)) {
+			return -1;
+		}
+		replacementPolicy = LOCAL_REPLACEMENT;
+		staticQuota = n;
+	} else {
+		return -1;
+	}
+
+	printReplacementPolicy();
+	return 0;
+}
+
+// Performs the 'pagedaemon' command
+// 'pagedaemon LOW HIGH' makes the page daemon evict the coldest frames whenever fewer than LOW frames are free,
+// until HIGH frames are free, and 'pagedaemon off' stops it.
+int pagedaemonCommand(char *words[]) {
+	if (strcmp(words[1], "off") == 0 && words[2] == NULL) {
+		lowWatermark = 0;
+		highWatermark = 0;
+	} else {
+		long low, high;
+		if (words[2] == NULL || words[3] != NULL || parseNumber(words[1], 1, FRAME_COUNT - 1, &low) != 0
+				|| parseNumber(words[2], low, FRAME_COUNT - 1, &high) != 0) {
+			return -1;
+		}
+		lowWatermark = (int) low;
+		highWatermark = (int) high;
+	}
+
+	printPageDaemon();
+	return 0;
+}
+
+// Checks, before the outermost 'run', 'exec' or 'spawn' command executes the scripts names, that they cannot run
+// themselves endlessly. type is CALL_RUN for the 'run' command, and CALL_PROCESS for the commands that start the
+// scripts as processes. The scripts executed by other scripts were checked with the outermost script.
+// Returns 0, or -1 if a cycle of 'run' calls was found, which is displayed as an error
+int checkRunCycles(char *names[], int count, int type) {
+	if (scriptStackIndex > 0) {
+		return 0;
+	}
+
+	char cycle[INSTRUCTION_SIZE];
+	if (findRunCycle(names, count, type, cycle, INSTRUCTION_SIZE)) {
+		printf("Error: The scripts would run each other endlessly: %s\n", cycle);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Displays the error of a script that could not be launched
+void printLaunchError(char *name, int error) {
+	if (error == -1) {
+		printf("Error: Script '%s' could not be loaded since it has more than %d instructions!\n", name, RAM_SIZE);
+	} else if (error == -3) {
+		printf("Error: Script '%s' could not be loaded since it is not a valid compiled script!\n", name);
+	} else {
+		printf("Error: Script '%s' could not be loaded because a victim frame could not be found!\n", name);
+	}
+}
+
 // Performs the 'exec' command.
 // The 'exec' command will execute up to three files concurrently.
 // Unlike the 'run' command, 'exec' will use the paging memeory management scheme,
 // which will create page files in the backing store.
-void exec(char *names[], int size) {
+// The processes form a job for the command in words. If background is 1, the command returns once the
+// processes are loaded, and they are executed between the next commands of the shell.
+void exec(char *names[], int size, char *words[], int background) {
 	int i;
 	FILE* files[3];
 
 	for (i = 0; i < size; i++) {
 		if (! (files[i] = fopen(names[i], "r"))) {
 			printf("Error: Script '%s' not found\n", names[i]);
-			clearRam();
+			releaseIdleMemory();
 			return;
 		}
 
 		fclose(files[i]);
 	}
+
+	if (checkRunCycles(names, size, CALL_PROCESS) != 0) {
+		releaseIdleMemory();
+		return;
+	}
 	
-	for (int i = 0; i < size; i++) {
-		// Load file into ram, create PCB for that program, and add PCB to ready queue
-		int error = launcher(names[i]);
-		if (error != 0) { // There is a load error
-			if (error == -1) {
-				printf("Error: Script '%s' could not be loaded since it has more than %d instructions!\n", names[i], RAM_SIZE);
-			} else {
-				printf("Error: Script '%s' could not be loaded because a victim frame could not be found!\n", names[i]);
-			}
+	int job = createJob(words, background);
 
-			clearRam();
-			clearReadyQueue();
-			return;
+	// Load the files into ram, create a PCB for each program, and add the PCBs to the ready queue
+	struct LaunchRequest requests[3];
+	for (i = 0; i < size; i++) {
+		requests[i].filename = names[i];
+		requests[i].job = job;
+	}
+
+	i = launchScripts(requests, size);
+	if (i != -1) { // There is a load error
+		printLaunchError(names[i], requests[i].error);
+		killJob(job);
+		cancelJob(job);
+		releaseIdleMemory();
+		return;
+	}
+
+	if (background) {
+		admitLaunches(); // The requests do not outlive the command
+		printf("[%d] Started\n", job);
+	} else {
+		waitForJob(job); // The other processes are admitted after the first quantum
+		admitLaunches();
+	}
+}
+
+// Performs the 'spawn' command
+// The script name is launched once, and count - 1 more processes running it are cloned from its PCB. The clones share
+// its image and the frames it loaded, so creating them does not read the script, and the job uses as many frames
+// as a single process until the processes fault on different pages. The processes form a job, like with 'exec'.
+void spawn(char *name, int count, char *words[], int background) {
+	FILE *f = fopen(name, "r");
+	if (f == NULL) {
+		printf("Error: Script '%s' not found\n", name);
+		releaseIdleMemory();
+		return;
+	}
+	fclose(f);
+
+	if (checkRunCycles(&name, 1, CALL_PROCESS) != 0) {
+		releaseIdleMemory();
+		return;
+	}
+
+	int job = createJob(words, background);
+
+	struct LaunchRequest request = { .filename = name, .job = job };
+	if (launchScripts(&request, 1) != -1) {
+		printLaunchError(name, request.error);
+		killJob(job);
+		cancelJob(job);
+		releaseIdleMemory();
+		return;
+	}
+
+	int i;
+	for (i = 1; i < count; i++) {
+		cloneProcess(request.pcb);
+	}
+
+	if (background) {
+		printf("[%d] Started\n", job);
+	} else {
+		waitForJob(job);
+	}
+}
+
+// Executes one quantum of the background jobs, as if it came from the 'exec' command
+// This is called by the shell while it waits for the user to enter a command.
+// Returns 1 if a process was executed, and 0 if no process could run
+int executeBackgroundQuantum() {
+	if (pushToScriptStack(EXEC) != 0) {
+		return 0;
+	}
+
+	executingScript = 1;
+	int executed = schedulerStep();
+	executingScript = 0;
+	popFromScriptStack();
+
+	releaseIdleMemory();
+	return executed;
+}
+
+// Performs the 'jobs' command
+void jobs() {
+	printJobs();
+}
+
+// Performs the 'wait' command
+// Executes the processes in the ready queue until the job with ID job (or every job of the current owner if job is ALL_JOBS) has finished
+void waitCommand(int job) {
+	if (pushToScriptStack(EXEC) == 0) {
+		executingScript = 1;
+		waitForJob(job);
+		executingScript = 0;
+		popFromScriptStack();
+	} else {
+		scriptStackIsFullError();
+	}
+}
+
+// Performs the 'kill' command
+// A process that kills its own job is terminated as well, once the instruction is over, as if it executed 'quit'
+void killCommand(int job) {
+	int count = killJob(job);
+	if (runningPCB != NULL && runningPCB->job == job) {
+		quitExecutingScript = 1; // The scripts it runs with 'run' stop too
+		count++;
+	}
+	cancelJob(job);
+	printf("[%d] Killed (%d process%s)\n", job, count, count == 1 ? "" : "es");
+	releaseIdleMemory();
+}
+
+// Returns 1 if the instruction being interpreted belongs to a process executed with 'exec', which can be blocked
+// Instructions typed by the user or read by the 'run' command cannot be blocked, so they fail instead.
+int instructionCanBlock() {
+	return runningPCB != NULL && peekFromScriptStack() == EXEC;
+}
+
+// Performs the 'send' command
+// A process that sends to a full channel is blocked until a message is received from the channel
+void sendCommand(char *name, char *value) {
+	int channel = findChannel(name, 1);
+	if (channel == NO_CHANNEL) {
+		printf("Error: Channel '%s' could not be created since there are already %d channels\n", name, CHANNEL_COUNT);
+	} else if (sendMessage(channel, value) != 0) {
+		if (instructionCanBlock()) {
+			cpu.waitChannel = channel;
+		} else {
+			printf("Error: Channel '%s' is full\n", name);
 		}
 	}
+}
 
-	// Start execution of all the loaded programs
-	scheduler();
+// Performs the 'recv' command
+// A process that receives from an empty channel is blocked until a message is sent to the channel
+void recvCommand(char *name, char *var) {
+	int channel = findChannel(name, 1);
+	if (channel == NO_CHANNEL) {
+		printf("Error: Channel '%s' could not be created since there are already %d channels\n", name, CHANNEL_COUNT);
+		return;
+	}
 
-	// Clear the ram once all loaded programs have finished execution
-	clearRam();
+	char *value = receiveMessage(channel);
+	if (value != NULL) {
+		setVar(var, value);
+		free(value);
+	} else if (instructionCanBlock()) {
+		cpu.waitChannel = channel;
+	} else {
+		printf("Error: Channel '%s' is empty\n", name);
+	}
+}
 
-	// Clear the ready queue
-	clearReadyQueue();
+// Executes a compiled script for the 'run' command
+// Its instructions are already split into words, so they are passed to the interpreter without being parsed
+void runCompiledScript(char *file) {
+	int error;
+	struct Bytecode *bc = mapBytecode(file, &error);
+	if (bc == NULL) {
+		if (error == -1) {
+			printf("Error: script '%s' not found\n", file);
+		} else {
+			printf("Error: script '%s' is not a valid compiled script\n", file);
+		}
+		return;
+	}
+
+	char *words[BYTECODE_MAX_WORDS + 1];
+	uint32_t position = 0;
+	int newline;
+
+	uint32_t i;
+	for (i = 0; i < bc->header->lineCount; i++) {
+		decodeInstruction(bc, &position, words, &newline);
+		interpretWords(words);
+
+		if (quitRunningScript == 1) { // Stop running the script if the quit command was executed
+			quitRunningScript = 0;
+			break;
+		}
+
+		if (quitExecutingScript == 1) { // The process that runs the script is terminated
+			break;
+		}
+	}
+
+	unmapBytecode(bc);
+}
+
+// Performs the 'compile' command
+// The compiled script is named after file, with the extension .kbc instead of .txt
+void compile(char *file) {
+	char target[INSTRUCTION_SIZE];
+	int len = strlen(file);
+	if (len > 4 && strcmp(file + len - 4, ".txt") == 0) {
+		len -= 4;
+	}
+	snprintf(target, INSTRUCTION_SIZE, "%.*s.kbc", len, file);
+
+	switch (compileScript(file, target)) {
+		case 0: printf("Compiled '%s' into '%s'\n", file, target); break;
+		case -1: printf("Error: Script '%s' not found\n", file); break;
+		case -2: printf("Error: '%s' could not be written\n", target); break;
+		case -3: printf("Error: Script '%s' has a line longer than %d characters\n", file, INSTRUCTION_SIZE - 2); break;
+	}
 }
 
 // Performs the 'run' command.
 // The 'run' command will not use the paging memory management scheme,
 // unlike the 'exec' command.
+// A compiled script (.kbc file) is executed without being parsed, and a script that would run itself endlessly is not executed.
 void runCommand(char* file) {
-	FILE* f;
+	if (checkRunCycles(&file, 1, CALL_RUN) != 0) {
+		return;
+	}
+
+	if (isBytecodeFile(file)) {
+		runCompiledScript(file);
+		return;
+	}
 
-	if (! (f = fopen(file, "r"))) {
+	struct ScriptReader reader;
+	if (openScriptReader(&reader, file) != 0) {
 	       printf("Error: script '%s' not found\n", file);
 	       return;
 	}
 
-	char line[INSTRUCTION_SIZE];
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
-	while (1) {
-		strcpy(line, "\0"); // Clear the line
-		fgets(line, INSTRUCTION_SIZE - 1, f); // Read the next line from the file, up to a maximum of INSTRUCTION_SIZE - 1 characters
-		int len = strlen(line); // Compute the length of the line
-		int endOfFile = len == 0 || line[len - 1] != '\n' || line[0] == EOF; // The line does not end with a new line character or is the EOF character, which means the end of the file has been reached
+	char *line;
+	int newline;
+	while ((line = readScriptLine(&reader, &newline)) != NULL) { // Read the next line from the file, whatever its length
+		size_t len = strlen(line);
+		scriptStats.lines++;
+		if ((long) len > scriptStats.longestLine) {
+			scriptStats.longestLine = (long) len;
+		}
 
 		parse(line);
 
-		if (endOfFile) { // Stop executing the script if the end of the file has been reached
+		if (!newline) { // Stop executing the script if the end of the file has been reached
 			break;
 		}
 
@@ -202,9 +708,20 @@ void runCommand(char* file) {
 			quitRunningScript = 0;
 			break;
 		}
+
+		if (quitExecutingScript == 1) { // The process that runs the script is terminated
+			break;
+		}
+	}
+
+	scriptStats.scripts++;
+	scriptStats.bytes += reader.offset;
+	closeScriptReader(&reader);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (runningScript == 1) { // Only the outermost script is timed, since it includes the scripts it runs
+		scriptStats.seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 	}
-	
-	fclose(f);
 }
 
 // Prints an error for an unknown command
@@ -220,24 +737,76 @@ void unknown(char* command, int error) {
 		case -8: printf("Error: The 'exec' command cannot take more than three parameters!\n"); break;
 		case -9: printf("Error: Recursive 'exec' calls are not supported!\n"); break;
 		case -10: printf("Error: Unknown command '%s'\n", command); break;
+		case -11: printf("Error: The 'checkpoint' command must take exactly one parameter!\n"); break;
+		case -12: printf("Error: The 'restore' command must take exactly one parameter!\n"); break;
+		case -13: printf("Error: The 'restore' command cannot be used by a script!\n"); break;
+		case -14: printf("Error: Usage: tlb [SIZE WAYS lru|fifo|random flush|tag], where WAYS divides SIZE and SIZE is at most %d\n", TLB_MAX_ENTRIES); break;
+		case -15: printf("Error: The 'vmstat' command cannot take parameters!\n"); break;
+		case -16: printf("Error: Usage: replacement global|local [N], where N is between 1 and %d\n", FRAME_COUNT); break;
+		case -17: printf("Error: Only the 'run', 'exec' and 'spawn' commands can be executed in the background!\n"); break;
+		case -18: printf("Error: The 'jobs' command cannot take parameters!\n"); break;
+		case -19: printf("Error: The 'wait' command takes at most one parameter!\n"); break;
+		case -20: printf("Error: The 'kill' command must take exactly one parameter!\n"); break;
+		case -21: printf("Error: The 'wait' command cannot be used by a script executed with 'exec'!\n"); break;
+		case -22: printf("Error: The '%s' command was given a job that does not exist!\n", command); break;
+		case -23: printf("Error: The 'send' command must take exactly two parameters!\n"); break;
+		case -24: printf("Error: The 'recv' command must take exactly two parameters!\n"); break;
+		case -25: printf("Error: The 'compile' command must take exactly one parameter!\n"); break;
+		case -26: printf("Error: The 'meminfo' command cannot take parameters!\n"); break;
+		case -27: printf("Error: Usage: simulate N INSTRUCTIONS PAGES seq|random|local [INTERVAL [LATENCY]], where PAGES is at most %d\n", RAM_SIZE / PAGE_SIZE); break;
+		case -28: printf("Error: The 'simulate' command cannot be used while processes exist or by a script!\n"); break;
+		case -29: printf("Error: The 'trace' command must take exactly one parameter!\n"); break;
+		case -30: printf("Error: Usage: pagedaemon LOW HIGH | pagedaemon off, where 1 <= LOW <= HIGH <= %d\n", FRAME_COUNT - 1); break;
+		case -31: printf("Error: Usage: spawn N SCRIPT, where N is between 1 and %d\n", SPAWN_MAX); break;
+		case -32: printf("Error: The 'spawn' command cannot be used by a process executed with 'exec'!\n"); break;
+		case -33: printf("Error: Usage: sleep N, where N is between 1 and %d\n", SLEEP_MAX); break;
+		case -34: printf("Error: The 'sleep' command can only be used by a script executed with 'exec'!\n"); break;
+		case -35: printf("Error: The 'runstat' command cannot take parameters!\n"); break;
 	}
 }
 
-// Stops all scripts being executed by the 'run' and 'exec' commands
-void stopAllScripts() {
-	mustResetInterpreterVariables = 1;
-	clearRam();
-	clearReadyQueue();
+// Performs the 'checkpoint' command
+// If it is executed by a script from the 'exec' command, the script will resume after this instruction when the checkpoint is restored
+void checkpoint(char *file) {
+	if (saveCheckpoint(file) != 0) {
+		printf("Error: Checkpoint could not be saved to '%s'\n", file);
+	} else {
+		printf("Checkpoint saved to '%s'\n", file);
+	}
 }
 
-// Handles the error of the script stack being full
-void scriptStackIsFullError() {
-	printf("Error: Maximum recursion depth (%d) reached\n", SCRIPT_STACK_SIZE);
-	stopAllScripts();
+// Performs the 'restore' command
+// Replaces the state of the kernel with the checkpoint saved in file, and then
+// resumes the execution of the processes that were in the ready queue, if any
+int restoreCommand(char *file) {
+	int error = restoreCheckpoint(file);
+	if (error == -1) {
+		printf("Error: Checkpoint '%s' could not be read\n", file);
+		return error;
+	} else if (error != 0) {
+		printf("Error: '%s' is not a valid checkpoint\n", file);
+		return error;
+	}
+
+	printf("Checkpoint restored from '%s'\n", file);
+
+	if (processList != NULL) { // Resume the processes as if they were executed with the 'exec' command
+		char *words[] = { "restore", file, NULL };
+		int job = createJob(words, 0);
+		struct PCB *pcb;
+		for (pcb = processList; pcb != NULL; pcb = pcb->nextProcess) {
+			pcb->job = job;
+		}
+
+		waitCommand(job);
+	}
+
+	return 0;
 }
 
 // Interprets parsed input from the user and runs the appropritate command
 int interpreter(char *words[]) {
+	PROBE(PROBE_INTERPRETER);
 
 	// The interpreter variables must be reset after stopAllScripts() is called
 	if (mustResetInterpreterVariables) {
@@ -260,7 +829,20 @@ int interpreter(char *words[]) {
 
 	int errorCode = 0;
 
-	if (strcmp(words[0], "help") == 0) {
+	// A command that ends with '&' is executed in the background
+	int background = 0;
+	int last = 0;
+	while (words[last + 1] != NULL) {
+		last++;
+	}
+	if (last > 0 && strcmp(words[last], "&") == 0) {
+		background = 1;
+		words[last] = NULL;
+	}
+
+	if (background && strcmp(words[0], "run") != 0 && strcmp(words[0], "exec") != 0 && strcmp(words[0], "spawn") != 0) {
+		errorCode = -17;
+	} else if (strcmp(words[0], "help") == 0) {
 		if (words[1] == NULL) {
 			help();
 		} else {
@@ -291,7 +873,12 @@ int interpreter(char *words[]) {
 			errorCode = -5;
 		}
 	} else if (strcmp(words[0], "run") == 0) {
-		if (words[1] != NULL && words[2] == NULL) {
+		if (words[1] != NULL && words[2] == NULL && background && executingScript == 1) {
+			errorCode = -9;
+		} else if (words[1] != NULL && words[2] == NULL && background) {
+			// A script run in the background is executed as a process, like with the 'exec' command
+			exec(&words[1], 1, words, 1);
+		} else if (words[1] != NULL && words[2] == NULL) {
 			if(pushToScriptStack(RUN) == 0) { // Try to push 1 to the script stack to indicate that this script was executed with the 'run' command
 				// If the stack is not full, proceed with the run command
 				runningScript++; // Increment the number of nested run commands being executed
@@ -331,7 +918,7 @@ int interpreter(char *words[]) {
 				// If the stack is not full, proceed with the exec command
 				// Execute the parameters (which are file names)
 				executingScript = 1; // Indicate that the 'exec' command is running
-				exec(parameters, len); // Execute the parameter scripts
+				exec(parameters, len, words, background); // Execute the parameter scripts
 				executingScript = 0; // Indicate that the 'exec' command is not running
 				popFromScriptStack(); // Pop the -1 from the script stack since the parameters are no longer being executed
 			} else {
@@ -339,6 +926,127 @@ int interpreter(char *words[]) {
 				scriptStackIsFullError();
 			}
 		}
+	} else if (strcmp(words[0], "spawn") == 0) {
+		long count;
+		if (words[1] == NULL || words[2] == NULL || words[3] != NULL || parseNumber(words[1], 1, SPAWN_MAX, &count) != 0) {
+			errorCode = -31;
+		} else if (executingScript == 1) {
+			errorCode = -32;
+		} else if (pushToScriptStack(EXEC) == 0) { // The processes are executed like the scripts of 'exec'
+			executingScript = 1;
+			spawn(words[2], (int) count, words, background);
+			executingScript = 0;
+			popFromScriptStack();
+		} else {
+			scriptStackIsFullError();
+		}
+	} else if (strcmp(words[0], "sleep") == 0) {
+		long n;
+		if (words[1] == NULL || words[2] != NULL || parseNumber(words[1], 1, SLEEP_MAX, &n) != 0) {
+			errorCode = -33;
+		} else if (!instructionCanBlock()) {
+			errorCode = -34;
+		} else {
+			cpu.sleepTicks = (int) n; // The scheduler puts the process to sleep after the instruction
+		}
+	} else if (strcmp(words[0], "jobs") == 0) {
+		if (words[1] == NULL) {
+			jobs();
+		} else {
+			errorCode = -18;
+		}
+	} else if (strcmp(words[0], "wait") == 0) {
+		if (words[1] != NULL && words[2] != NULL) {
+			errorCode = -19;
+		} else if (executingScript) {
+			errorCode = -21;
+		} else if (words[1] != NULL && !jobExists(atoi(words[1]))) {
+			errorCode = -22;
+		} else {
+			waitCommand(words[1] == NULL ? ALL_JOBS : atoi(words[1]));
+		}
+	} else if (strcmp(words[0], "kill") == 0) {
+		if (words[1] == NULL || words[2] != NULL) {
+			errorCode = -20;
+		} else if (!jobExists(atoi(words[1]))) {
+			errorCode = -22;
+		} else {
+			killCommand(atoi(words[1]));
+		}
+	} else if (strcmp(words[0], "compile") == 0) {
+		if (words[1] != NULL && words[2] == NULL) {
+			compile(words[1]);
+		} else {
+			errorCode = -25;
+		}
+	} else if (strcmp(words[0], "send") == 0) {
+		if (words[1] != NULL && words[2] != NULL && words[3] == NULL) {
+			sendCommand(words[1], words[2]);
+		} else {
+			errorCode = -23;
+		}
+	} else if (strcmp(words[0], "recv") == 0) {
+		if (words[1] != NULL && words[2] != NULL && words[3] == NULL) {
+			recvCommand(words[1], words[2]);
+		} else {
+			errorCode = -24;
+		}
+	} else if (strcmp(words[0], "checkpoint") == 0) {
+		if (words[1] != NULL && words[2] == NULL) {
+			checkpoint(words[1]);
+		} else {
+			errorCode = -11;
+		}
+	} else if (strcmp(words[0], "restore") == 0) {
+		if (words[1] == NULL || words[2] != NULL) {
+			errorCode = -12;
+		} else if (runningScript || executingScript) {
+			errorCode = -13;
+		} else {
+			restoreCommand(words[1]);
+		}
+	} else if (strcmp(words[0], "tlb") == 0) {
+		if (tlbCommand(words) != 0) {
+			errorCode = -14;
+		}
+	} else if (strcmp(words[0], "vmstat") == 0) {
+		if (words[1] == NULL) {
+			vmstat();
+		} else {
+			errorCode = -15;
+		}
+	} else if (strcmp(words[0], "meminfo") == 0) {
+		if (words[1] == NULL) {
+			meminfo();
+		} else {
+			errorCode = -26;
+		}
+	} else if (strcmp(words[0], "runstat") == 0) {
+		if (words[1] == NULL) {
+			runstat();
+		} else {
+			errorCode = -35;
+		}
+	} else if (strcmp(words[0], "trace") == 0) {
+		if (words[1] != NULL && words[2] == NULL) {
+			traceCommand(words[1]);
+		} else {
+			errorCode = -29;
+		}
+	} else if (strcmp(words[0], "simulate") == 0) {
+		if (processList != NULL || runningScript || executingScript) {
+			errorCode = -28;
+		} else if (simulateCommand(words) != 0) {
+			errorCode = -27;
+		}
+	} else if (strcmp(words[0], "replacement") == 0) {
+		if (words[1] == NULL || (words[2] != NULL && words[3] != NULL) || replacement(words[1], words[2]) != 0) {
+			errorCode = -16;
+		}
+	} else if (strcmp(words[0], "pagedaemon") == 0) {
+		if (words[1] == NULL || pagedaemonCommand(words) != 0) {
+			errorCode = -30;
+		}
 	} else {
 		errorCode = -10;
 	}
@@ -5,9 +5,14 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
-int quitRunningScript;
-int quitExecutingScript;
+#include "state.h" // For KERNEL_STATE
+
+extern KERNEL_STATE int quitRunningScript;
+extern KERNEL_STATE int quitExecutingScript;
 
 int interpreter(char* words[]);
+int restoreCommand(char *file);
+int executeBackgroundQuantum();
+void releaseIdleMemory();
 
 #endif
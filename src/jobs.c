@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file keeps track of jobs, the groups of processes created by the 'exec' command
+// Jobs started with '&' run in the background while the shell keeps accepting commands.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jobs.h"
+#include "pcb.h"
+
+KERNEL_STATE struct Job *jobList = NULL; // The list of jobs that have not been reported as finished, oldest first
+KERNEL_STATE int lastJobID = 0; // Last job ID
+KERNEL_STATE int currentOwner = 0; // The ID of the server session whose commands or processes are executing, or 0 for the console
+KERNEL_STATE void (*ownerChanged)(int owner) = NULL; // Called by switchOwner() before the current owner changes, in server mode
+
+// Creates a job for the command in words, and returns its ID
+int createJob(char *words[], int background) {
+	struct Job *job = (struct Job *) malloc(sizeof(struct Job));
+	job->id = ++lastJobID;
+	job->background = background;
+	job->owner = currentOwner;
+	job->next = NULL;
+
+	// Rebuild the command from its words
+	job->command[0] = '\0';
+	int i;
+	for (i = 0; words[i] != NULL; i++) {
+		if (i > 0) {
+			strncat(job->command, " ", INSTRUCTION_SIZE - strlen(job->command) - 1);
+		}
+		strncat(job->command, words[i], INSTRUCTION_SIZE - strlen(job->command) - 1);
+	}
+
+	// Add the job to the end of the job list
+	if (jobList == NULL) {
+		jobList = job;
+	} else {
+		struct Job *last = jobList;
+		while (last->next != NULL) {
+			last = last->next;
+		}
+		last->next = job;
+	}
+
+	return job->id;
+}
+
+// Returns the owner of the job with ID id, or the current owner if the job does not exist
+int jobOwner(int id) {
+	struct Job *job;
+	for (job = jobList; job != NULL; job = job->next) {
+		if (job->id == id) {
+			return job->owner;
+		}
+	}
+
+	return currentOwner;
+}
+
+// Makes owner the current owner, so that the jobs it creates belong to it and the jobs of the other owners are
+// hidden from it
+// Returns the previous owner
+int switchOwner(int owner) {
+	int previous = currentOwner;
+	if (owner != previous) {
+		if (ownerChanged != NULL) {
+			ownerChanged(owner);
+		}
+		currentOwner = owner;
+	}
+
+	return previous;
+}
+
+// Returns 1 if a process of the job with ID processJob belongs to the job with ID id (or to a job of the current
+// owner if id is ALL_JOBS), and 0 otherwise
+int jobMatches(int processJob, int id) {
+	if (id == ALL_JOBS) {
+		return jobOwner(processJob) == currentOwner;
+	}
+
+	return processJob == id;
+}
+
+// Returns the ID of the oldest job of the current owner, or 0 if it has no job
+int firstJob() {
+	struct Job *job;
+	for (job = jobList; job != NULL; job = job->next) {
+		if (job->owner == currentOwner) {
+			return job->id;
+		}
+	}
+
+	return 0;
+}
+
+// Returns 1 if the job with ID id belongs to the current owner and has not been reported as finished, and 0 otherwise
+int jobExists(int id) {
+	struct Job *job;
+	for (job = jobList; job != NULL; job = job->next) {
+		if (job->id == id && job->owner == currentOwner) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Counts the processes of the job with ID id (or of every job of the current owner if id is ALL_JOBS) that have
+// not terminated
+int countJobProcesses(int id) {
+	int count = 0;
+	struct PCB *pcb;
+	for (pcb = processList; pcb != NULL; pcb = pcb->nextProcess) {
+		if (jobMatches(pcb->job, id)) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+// Returns 1 if a background job of the current owner still has processes to execute, and 0 otherwise
+int hasBackgroundJobs() {
+	struct Job *job;
+	for (job = jobList; job != NULL; job = job->next) {
+		if (job->background && job->owner == currentOwner && countJobProcesses(job->id) > 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Displays the background jobs of the current owner that are running
+void printJobs() {
+	struct Job *job;
+	for (job = jobList; job != NULL; job = job->next) {
+		int processes = countJobProcesses(job->id);
+		if (job->background && job->owner == currentOwner && processes > 0) {
+			printf("[%d] Running (%d process%s)\t%s\n", job->id, processes, processes == 1 ? "" : "es", job->command);
+		}
+	}
+}
+
+// Removes the job with ID id without reporting it, which is used when its processes could not be launched
+void cancelJob(int id) {
+	struct Job **link = &jobList;
+	while (*link != NULL) {
+		struct Job *job = *link;
+		if (job->id == id) {
+			*link = job->next;
+			free(job);
+			return;
+		}
+		link = &job->next;
+	}
+}
+
+// Removes the jobs of the current owner whose processes have all terminated, and reports the background ones
+void reportFinishedJobs() {
+	struct Job **link = &jobList;
+	while (*link != NULL) {
+		struct Job *job = *link;
+		if (job->owner == currentOwner && countJobProcesses(job->id) == 0) {
+			if (job->background) {
+				printf("[%d] Done\t%s\n", job->id, job->command);
+			}
+			*link = job->next;
+			free(job);
+		} else {
+			link = &job->next;
+		}
+	}
+}
+
+// Forgets every job, without reporting them
+void clearJobs() {
+	while (jobList != NULL) {
+		struct Job *job = jobList;
+		jobList = job->next;
+		free(job);
+	}
+}
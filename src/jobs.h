@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "cpu.h" // For INSTRUCTION_SIZE
+
+enum {
+	ALL_JOBS = 0 // Refers to every job, in functions that take a job ID
+};
+
+// This structure represents a job: the processes created by one 'exec' or 'run &' command
+// A job is finished once none of its processes remains in the process list
+struct Job {
+	int id; // The job ID
+	int background; // 1 if the job was started with '&'
+	int owner; // The ID of the server session that started the job, or 0 for the console
+	char command[INSTRUCTION_SIZE]; // The command that started the job
+	struct Job *next; // The next job in the job list
+};
+
+extern KERNEL_STATE int currentOwner;
+extern KERNEL_STATE void (*ownerChanged)(int owner);
+
+int createJob(char *words[], int background);
+int jobOwner(int id);
+int switchOwner(int owner);
+int jobMatches(int processJob, int id);
+int firstJob();
+int jobExists(int id);
+int countJobProcesses(int id);
+int hasBackgroundJobs();
+void printJobs();
+void cancelJob(int id);
+void reportFinishedJobs();
+void clearJobs();
+
+#endif
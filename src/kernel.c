@@ -3,19 +3,47 @@
  * SPDX-License-Identifier: MIT
  */
 // This file simulates an operating system kernel
+#define _GNU_SOURCE // For nftw()
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "interpreter.h"
 #include "shell.h"
 #include "cpu.h"
 #include "memorymanager.h"
+#include "kernel.h"
+#include "shellmemory.h"
+#include "threadpool.h"
+#include "jobs.h"
+#include "callgraph.h"
+#include "timer.h"
+#include "channel.h"
+#include "probe.h"
+#include "arena.h"
+#include "trace.h"
 
-const char* BACKING_STORE = "BackingStore"; // The backing store directory
-enum { BUFFER_SIZE = 100 };
-char removeBackingStore[BUFFER_SIZE]; // The command to remove the backing store directory
-char createBackingStore[BUFFER_SIZE]; // The command to create the backing store directory
+const char* BACKING_STORE = "BackingStore"; // The default backing store directory
+KERNEL_STATE char backingStore[BACKING_STORE_SIZE]; // The backing store directory of the kernel
+KERNEL_STATE struct PCB *runningPCB = NULL; // The PCB whose instructions the CPU is currently executing, if any
+
+// Define constants for load control, which suspends processes when the kernel is thrashing
+// THRASH_WINDOW, the number of dispatches over which the page-fault rate is measured, is defined in kernel.h
+enum {
+	THRASH_HIGH = 50, // The page-fault rate (percentage of dispatches) above which the kernel is considered to be thrashing
+	THRASH_LOW = 20 // The page-fault rate (percentage of dispatches) below which a suspended process can be resumed
+};
+
+KERNEL_STATE int ticks = 0; // The number of dispatches performed by the scheduler
+KERNEL_STATE int faultWindow[THRASH_WINDOW] = { 0 }; // faultWindow[t % THRASH_WINDOW] is 1 if dispatch t caused a page fault
+KERNEL_STATE int faultsInWindow = 0; // The number of page faults during the last THRASH_WINDOW dispatches
+KERNEL_STATE int lastLoadControl = 0; // The tick of the last suspension or resumption
+KERNEL_STATE struct ReadyQueue *suspendedHead = NULL, *suspendedTail = NULL; // The queue of processes suspended by load control
+KERNEL_STATE struct VMStats vmstats = { 0 }; // Virtual memory statistics
 
 // Enqueue a ready queue node (which contains a PCB)
 void addRQToReady(struct ReadyQueue *rq) {
@@ -31,14 +59,21 @@ void addRQToReady(struct ReadyQueue *rq) {
 }
 
 // Creates a ready queue node from a PCB and enqueues it to the ready queue
+// The node is allocated from the session arena, and it is released to the arena when the process terminates
 void addPCBToReady(struct PCB *pcb) {
-	struct ReadyQueue *rq = (struct ReadyQueue *) malloc(sizeof(struct ReadyQueue));
+	struct ReadyQueue *rq = (struct ReadyQueue *) arenaAlloc(&sessionArena, sizeof(struct ReadyQueue));
 	rq->pcb = pcb;
 	rq->next = NULL;
 
 	addRQToReady(rq);
 }
 
+// Terminates the process of the ready queue node rq, and releases the node
+void terminateProcess(struct ReadyQueue *rq) {
+	freePCB(rq->pcb);
+	arenaFree(&sessionArena, rq, sizeof(struct ReadyQueue));
+}
+
 // Dequeue a ready queue node (which contains a PCB)
 struct ReadyQueue *removeFromReady() {
 	if (head == NULL) {
@@ -54,60 +89,327 @@ struct ReadyQueue *removeFromReady() {
 	return rq;
 }
 
-// Assigns PCB's to the CPU one at a time from the ready queue
-void scheduler() {
+// Handles a page fault of PCB pcb on page pageNumber
+int pageFault(struct PCB *pcb, int pageNumber) {
+	vmstats.pageFaults++;
+	faultWindow[ticks % THRASH_WINDOW] = 1;
+	return findLoadUpdate(pcb, pageNumber);
+}
+
+// Estimates the number of frames that the runnable processes need: the sum of their working sets,
+// which are the pages they executed during the last THRASH_WINDOW dispatches
+int workingSetDemand() {
+	int demand = 0;
+	struct ReadyQueue *node;
+	for (node = head; node != NULL; node = node->next) {
+		int i;
+		for (i = 0; i < node->pcb->pages_max; i++) {
+			if (node->pcb->lastUse[i] != -1 && ticks - node->pcb->lastUse[i] < THRASH_WINDOW) {
+				demand++;
+			}
+		}
+	}
+
+	return demand;
+}
+
+// Suspends the process in the ready queue that holds the most frames: all of its pages are swapped
+// out and it is moved from the ready queue to the suspended queue
+void suspendProcess() {
+	struct ReadyQueue *node, *previous = NULL;
+	struct ReadyQueue *victim = head, *victimPrevious = NULL;
+	for (node = head; node != NULL; previous = node, node = node->next) {
+		if (residentPages(node->pcb) > residentPages(victim->pcb)) {
+			victim = node;
+			victimPrevious = previous;
+		}
+	}
+
+	// Remove the victim from the ready queue
+	if (victimPrevious == NULL) {
+		head = victim->next;
+	} else {
+		victimPrevious->next = victim->next;
+	}
+	if (tail == victim) {
+		tail = victimPrevious;
+	}
+
+	releaseFrames(victim->pcb);
+
+	// Add the victim to the suspended queue
+	victim->next = NULL;
+	if (suspendedHead == NULL) {
+		suspendedHead = victim;
+	} else {
+		suspendedTail->next = victim;
+	}
+	suspendedTail = victim;
+
+	vmstats.suspensions++;
+}
+
+// Resumes the process that has been suspended for the longest time by adding it back to the ready queue
+// Its pages are loaded again by page faults when it is dispatched
+void resumeProcess() {
+	struct ReadyQueue *rq = suspendedHead;
+	suspendedHead = rq->next;
+	if (suspendedHead == NULL) {
+		suspendedTail = NULL;
+	}
+
+	addRQToReady(rq);
+}
+
+// Moves every suspended process back to the ready queue
+void resumeAllProcesses() {
+	while (suspendedHead != NULL) {
+		resumeProcess();
+	}
+}
+
+// Counts the processes in the suspended queue
+int countSuspended() {
+	int count = 0;
+	struct ReadyQueue *node;
+	for (node = suspendedHead; node != NULL; node = node->next) {
+		count++;
+	}
+
+	return count;
+}
+
+// Returns the page-fault rate over the last THRASH_WINDOW dispatches, as a percentage
+int pageFaultRate() {
+	return faultsInWindow * 100 / THRASH_WINDOW;
+}
+
+// Returns a copy of the page-fault window, so that it can be restored once the dispatches that follow are over
+struct FaultWindow saveFaultWindow() {
+	struct FaultWindow window = { .count = faultsInWindow, .lastLoadControl = lastLoadControl };
+	memcpy(window.faults, faultWindow, sizeof(faultWindow));
+	return window;
+}
+
+// Restores the page-fault window saved by saveFaultWindow(), forgetting the dispatches performed since
+// The ticks keep counting, since the timer wheel has moved forward with them.
+void restoreFaultWindow(const struct FaultWindow *window) {
+	faultsInWindow = window->count;
+	lastLoadControl = window->lastLoadControl;
+	memcpy(faultWindow, window->faults, sizeof(faultWindow));
+}
+
+// Detects thrashing and limits the number of runnable processes
+// When the page-fault rate is high and the working sets of the runnable processes do not fit in RAM,
+// a process is suspended. When the page-fault rate has recovered, a suspended process is resumed.
+// At most one decision is made per window, so that the page-fault rate can reflect the previous one.
+void loadControl() {
+	if (suspendedHead != NULL && head == NULL) { // Nothing else can run
+		resumeProcess();
+		vmstats.resumptions++;
+		lastLoadControl = ticks;
+		return;
+	}
+
+	if (ticks - lastLoadControl < THRASH_WINDOW) {
+		return;
+	}
+
+	if (pageFaultRate() >= THRASH_HIGH && head != tail && workingSetDemand() > FRAME_COUNT) {
+		suspendProcess();
+		lastLoadControl = ticks;
+	} else if (pageFaultRate() <= THRASH_LOW && suspendedHead != NULL) {
+		resumeProcess();
+		vmstats.resumptions++;
+		lastLoadControl = ticks;
+	}
+}
+
+// Removes the PCB at the head of the ready queue and assigns it to the CPU
+// If its current page was evicted while it was waiting, a page fault is taken first.
+// Returns the ready queue node of the PCB, or NULL if no process can run
+struct ReadyQueue *dispatch() {
+	if (head == NULL) {
+		loadControl(); // Resume a suspended process, if any
+	}
+	if (head == NULL && timerWheel.count > 0) {
+		ticks = wakeNextSleeper(); // Every process is asleep, so the CPU is idle until the first one wakes up
+	}
+
 	struct ReadyQueue *rq = removeFromReady();
-	while (rq != NULL) { // While the ready queue is not empty
-		int pcbTerminated = 0;
-		// Copy the offset from the PCB into the offset of the CPU
-		cpu.offset = rq->pcb->PC_offset;
-		// Copy the frame number from the PCB into the IP of the CPU
-		cpu.IP = rq->pcb->pageTable[rq->pcb->PC_page];
-
-		// Run quanta instructions
-		int tag = run(cpu.quanta);
-
-		if (tag == -1) { // Error
-			// Do something
+	if (rq == NULL) {
+		return NULL;
+	}
+
+	// Copy the offset from the PCB into the offset of the CPU
+	cpu.offset = rq->pcb->PC_offset;
+	// Copy the frame number from the PCB into the IP of the CPU
+	faultsInWindow -= faultWindow[ticks % THRASH_WINDOW]; // Forget the dispatch that leaves the window
+	faultWindow[ticks % THRASH_WINDOW] = 0;
+	cpu.IP = translate(rq->pcb, rq->pcb->PC_page);
+	traceAccess(rq->pcb, rq->pcb->PC_page, cpu.IP);
+	if (cpu.IP == -1) { // The page was taken by a victim selection or a suspension while the PCB was waiting
+		// Page fault
+		pageFault(rq->pcb, rq->pcb->PC_page);
+		cpu.IP = translate(rq->pcb, rq->pcb->PC_page);
+	}
+	rq->pcb->lastUse[rq->pcb->PC_page] = ticks;
+
+	return rq;
+}
+
+// Ends the dispatch of a PCB: the page-fault rate is updated, the processes whose sleep is over are woken up,
+// load control is performed and the page daemon runs
+// The page daemon runs between dispatches, like a kernel thread that the scheduler switches to, since the state
+// of the kernel belongs to the thread that booted it.
+void endDispatch() {
+	faultsInWindow += faultWindow[ticks % THRASH_WINDOW];
+	ticks++;
+	advanceTimers(ticks);
+	loadControl();
+	pageDaemon(ticks);
+}
+
+// Assigns the PCB at the head of the ready queue to the CPU for one quantum
+// Returns 1 if a PCB was executed, and 0 if the ready queue was empty
+int schedulerStep() {
+	PROBE(PROBE_SCHEDULER_STEP);
+
+	struct ReadyQueue *rq = dispatch();
+	if (rq == NULL) {
+		return 0;
+	}
+
+	int pcbTerminated = 0;
+	int pcbBlocked = 0;
+
+	// Run quanta instructions, with the variables and the output of the session that started the job of the PCB
+	int owner = switchOwner(jobOwner(rq->pcb->job));
+	runningPCB = rq->pcb;
+	int tag = run(cpu.quanta);
+	runningPCB = NULL;
+	switchOwner(owner);
+
+	if (pendingLaunches != NULL) { // Processes launched with the one that ran join the ready queue ahead of it
+		admitLaunches();
+	}
+
+	if (tag == -1) { // Error
+		// Do something
+	}
+	else if (tag == 2) { // The instruction is blocked on a channel
+		// Park the PCB on the channel until a message (or room for one) is available
+		rq->pcb->PC_offset = cpu.offset;
+		blockOnChannel(cpu.waitChannel, rq);
+		cpu.waitChannel = -1;
+		pcbBlocked = 1;
+	}
+	else if (tag == 3) { // The process went to sleep
+		// Keep the PCB in the timer wheel until its wake-up tick
+		rq->pcb->PC_offset = cpu.offset;
+		addTimer(rq, ticks + cpu.sleepTicks);
+		cpu.sleepTicks = 0;
+		pcbBlocked = 1;
+	}
+	else if (tag == 1) { // CPU offset reached PAGE_SIZE
+		// Determine the next page and reset the offset
+		rq->pcb->PC_page++;
+		rq->pcb->PC_offset = 0;
+
+		if (rq->pcb->PC_page > rq->pcb->pages_max - 1) { // If there are no more pages to execute
+			pcbTerminated = 1;
+		} else {
+			// The process references its next page, which is a hit or a miss like the page of a dispatch
+			traceAccess(rq->pcb, rq->pcb->PC_page, rq->pcb->pageTable[rq->pcb->PC_page]);
+			if (rq->pcb->pageTable[(rq->pcb->PC_page)] == -1) { // If the page is not stored inside a frame in ram 
+				// Page fault
+				pageFault(rq->pcb, rq->pcb->PC_page);
+			}
 		}
-		else if (tag == 1) { // CPU offset reached PAGE_SIZE
-			// Determine the next page and reset the offset
-			rq->pcb->PC_page++;
-			rq->pcb->PC_offset = 0;
-
-			if (rq->pcb->PC_page > rq->pcb->pages_max - 1) { // If there are no more pages to execute
-				// Terminate the PCB
-				free(rq->pcb);
-				free(rq);
-				pcbTerminated = 1;
+	} else {
+		// Update PCB offset
+		rq->pcb->PC_offset = cpu.offset;
+	}
+	
+	if (quitExecutingScript || pcbTerminated ) { // If script needs to quit or the pcb has been terminated
+		// Terminate the PCB
+		terminateProcess(rq);
+
+		quitExecutingScript = 0; // Reset quitExecutingScript
+	} else if (!pcbBlocked) {
+		// Add PCB to end of ready queue
+		addRQToReady(rq); 
+	}
+
+	endDispatch();
+
+	return 1;
+}
+
+// Assigns PCB's to the CPU one at a time from the ready queue, until the ready queue is empty
+void scheduler() {
+	while (schedulerStep());
+}
+
+// Removes the nodes of the processes of job from a queue and terminates them
+// Returns the number of processes terminated
+int killFromQueue(struct ReadyQueue **queueHead, struct ReadyQueue **queueTail, int job) {
+	int count = 0;
+	struct ReadyQueue *previous = NULL;
+	struct ReadyQueue *node = *queueHead;
+	while (node != NULL) {
+		struct ReadyQueue *next = node->next;
+		if (jobMatches(node->pcb->job, job)) {
+			if (previous == NULL) {
+				*queueHead = next;
 			} else {
-				if (rq->pcb->pageTable[(rq->pcb->PC_page)] == -1) { // If the page is not stored inside a frame in ram 
-					// Page fault
-					findLoadUpdate(rq->pcb, rq->pcb->PC_page, rq->pcb->PID);
-				}
+				previous->next = next;
 			}
-		} else {
-			// Update PCB offset
-			rq->pcb->PC_offset = cpu.offset;
-		}
-		
-		if (quitExecutingScript || pcbTerminated ) { // If script needs to quit or the pcb has been terminated
-			if (!pcbTerminated) {
-				// Terminate the PCB
-				free(rq->pcb);
-				free(rq);
+			if (*queueTail == node) {
+				*queueTail = previous;
 			}
 
-			quitExecutingScript = 0; // Reset quitExecutingScript
+			terminateProcess(node);
+			count++;
 		} else {
-			// Add PCB to end of ready queue
-			addRQToReady(rq); 
+			previous = node;
 		}
+		node = next;
+	}
+
+	return count;
+}
+
+// Terminates every process of the job with ID job (or of every job of the current owner if job is ALL_JOBS)
+// Returns the number of processes terminated
+int killJob(int job) {
+	int count = killFromQueue(&head, &tail, job) + killFromQueue(&suspendedHead, &suspendedTail, job) + killSleeping(job);
+	count += killLaunches(job);
 
-		rq = removeFromReady();
+	int i;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		count += killFromQueue(&channels[i].waitHead, &channels[i].waitTail, job);
 	}
+
+	return count;
 }
 
+// Assigns PCB's to the CPU one at a time from the ready queue, until the job with ID job has finished
+// The processes of the other jobs are executed as well, since they share the ready queue.
+// If the processes of the job are blocked on channels while no process can run, they are deadlocked
+// and they are terminated. Returns the number of processes terminated because of a deadlock.
+int runJob(int job) {
+	while (countJobProcesses(job) > 0 && schedulerStep());
+
+	if (countJobProcesses(job) == 0) {
+		return 0;
+	}
+
+	return killJob(job); // The processes left are all blocked
+}
+
+
+
 // Creates a PCB and adds it to the ready queue
 struct PCB *initPCB(int PID, int pages_max) {
 	struct PCB *pcb = makePCB(PID, pages_max);
@@ -115,36 +417,99 @@ struct PCB *initPCB(int PID, int pages_max) {
 	return pcb;
 }
 
-// The commands to execute before starting the kernel
-int boot() {
-	int error = 0;
+// Removes the file or the directory path, which nftw() visits after the entries of the directory
+int removeEntry(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+	(void) st;
+	(void) ftw;
+	return type == FTW_DP ? rmdir(path) : unlink(path);
+}
+
+// Removes the backing store directory and its pages, if it exists
+// The path is never given to a shell, and a file that is not a directory is left alone.
+// Returns 0, or 1 if the directory could not be removed
+int removeBackingStore() {
+	struct stat st;
+	if (lstat(backingStore, &st) != 0 || !S_ISDIR(st.st_mode)) {
+		return 0; // Nothing to remove
+	}
+
+	if (nftw(backingStore, removeEntry, 16, FTW_DEPTH | FTW_PHYS) != 0 && errno != ENOENT) {
+		return 1;
+	}
+
+	return 0;
+}
 
-	// Initialize every cell of ram to NULL
-	for (int i = 0; i < RAM_SIZE; i++) {
-		ram[i] = NULL;
+// The commands to execute before starting the kernel, whose pages will be stored in the directory directory
+// Returns 0, or a positive value if the backing store could not be prepared, in which case nothing is left to shut down
+int boot(const char *directory) {
+	if (strlen(directory) >= BACKING_STORE_SIZE) {
+		return 1; // Error: the path is too long
 	}
+	strcpy(backingStore, directory);
+
+	// Allocate the large tables of the kernel on the heap, so that the thread-local state of every thread stays small.
+	// Every cell of ram is initialized to NULL and every frame is marked as free.
+	int error = 0;
+	error += allocateRam() != 0;
+	error += allocateImageCache() != 0;
+	error += createConsoleMemory() != 0;
 
 	// Prepare the Backing Store
-	snprintf(removeBackingStore, BUFFER_SIZE, "if [ -d \"%s\" ]; then rm -r BackingStore; fi", BACKING_STORE);
-	snprintf(createBackingStore, BUFFER_SIZE, "mkdir %s", BACKING_STORE);
-	error += system(removeBackingStore); // Remove the BackingStore directory if it exists
-	error += system(createBackingStore); // Create the BackingStore directory
+	if (error == 0) {
+		error = resetBackingStore();
+	}
+	if (error != 0) {
+		removeBackingStore(); // Remove what was created, if anything
+		freeRam();
+		freeImageCache();
+		freeConsoleMemory();
+		return error;
+	}
+
+	retainThreadPool();
+	return 0;
+}
 
+// Removes every page from the backing store
+int resetBackingStore() {
+	int error = 0;
+	error += removeBackingStore(); // Remove the BackingStore directory if it exists
+	error += mkdir(backingStore, 0777) != 0; // Create the BackingStore directory
 	return error;
 }
 
 // The commands to execute after exiting the kernel
 int shutDown() {
+	// Release the memory of the kernel, which matters when it is embedded in a program that keeps running
+	killJob(ALL_JOBS);
+	clearJobs();
+	clearRam();
+	unmapImages();
+	clearCallGraph();
+	freeArena(&sessionArena);
+	freeRam();
+	freeImageCache();
+	freeConsoleMemory();
+
+	releaseThreadPool();
+	PROBE_REPORT();
+	stopTrace();
+
 	// Remove the Backing Store if it exists
-	int error = system(removeBackingStore);
+	int error = removeBackingStore();
 	return error;
 }
 
 // Starts the kernel
-int kernel() {
+// If checkpoint is not NULL, the state of the kernel is first restored from the checkpoint file
+int kernel(char *checkpoint) {
 	int error = 0;
 
 	printf("Kernel loaded!\n");
+	if (checkpoint != NULL) {
+		error += restoreCommand(checkpoint);
+	}
 	error += shellUI();
 	printf("Exiting kernel...\n");
 
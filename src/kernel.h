@@ -5,10 +5,57 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
+#include "pcb.h" // For struct PCB
+
+enum {
+	BACKING_STORE_SIZE = 256, // The maximum length of the path of the backing store directory, including the null character
+	THRASH_WINDOW = 16 // The number of dispatches over which the page-fault rate is measured
+};
+
+extern const char *BACKING_STORE;
+extern KERNEL_STATE char backingStore[BACKING_STORE_SIZE];
+// Virtual memory statistics, displayed by the 'vmstat' command
+struct VMStats {
+	long pageFaults; // The number of page faults taken by the scheduler
+	long suspensions; // The number of processes suspended by load control
+	long resumptions; // The number of processes resumed by load control
+	long directReclaims; // The number of frames reclaimed by a page fault, which had to find a victim frame
+	long daemonReclaims; // The number of frames reclaimed ahead of time by the page daemon
+	long daemonRuns; // The number of times the page daemon found fewer free frames than the low watermark
+};
+
+// The recent dispatches over which load control measures the page-fault rate
+struct FaultWindow {
+	int faults[THRASH_WINDOW]; // faults[t % THRASH_WINDOW] is 1 if dispatch t caused a page fault
+	int count; // The number of page faults during the last THRASH_WINDOW dispatches
+	int lastLoadControl; // The tick of the last suspension or resumption
+};
+
+extern KERNEL_STATE struct PCB *runningPCB;
+extern KERNEL_STATE struct VMStats vmstats;
+extern KERNEL_STATE struct ReadyQueue *suspendedHead;
+
 struct PCB *initPCB(int PID, int pages_max);
+struct ReadyQueue;
+void addRQToReady(struct ReadyQueue *rq);
+void terminateProcess(struct ReadyQueue *rq);
+void addPCBToReady(struct PCB *pcb);
+struct ReadyQueue *dispatch();
+void endDispatch();
+int pageFault(struct PCB *pcb, int pageNumber);
+int schedulerStep();
 void scheduler();
-int boot();
-int kernel();
+int runJob(int job);
+int killFromQueue(struct ReadyQueue **queueHead, struct ReadyQueue **queueTail, int job);
+int killJob(int job);
+void resumeAllProcesses();
+int countSuspended();
+int pageFaultRate();
+struct FaultWindow saveFaultWindow();
+void restoreFaultWindow(const struct FaultWindow *window);
+int boot(const char *directory);
+int resetBackingStore();
+int kernel(char *checkpoint);
 int shutDown();
 
 #endif
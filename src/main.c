@@ -3,13 +3,38 @@
  * SPDX-License-Identifier: MIT
  */
 // This file starts the kernel and shell
+#include <stdio.h>
+#include <string.h>
+
 #include "kernel.h"
+#include "server.h"
 
 // Starts and exits the kernel
-int main() {
+// The kernel can be started from a checkpoint with: mykernel --restore FILE
+// It can also serve shell sessions to local clients on a UNIX domain socket with: mykernel --listen PATH
+int main(int argc, char *argv[]) {
+	char *checkpoint = NULL;
+	char *listenPath = NULL;
+
+	if (argc == 3 && strcmp(argv[1], "--restore") == 0) {
+		checkpoint = argv[2];
+	} else if (argc == 3 && strcmp(argv[1], "--listen") == 0) {
+		listenPath = argv[2];
+	} else if (argc != 1) {
+		printf("Usage: %s [--restore FILE | --listen PATH]\n", argv[0]);
+		return 1;
+	}
+
 	int error = 0;
-	error += boot(); // Performs the commands necessary before starting the kernel
-	error += kernel(); // Starts and eventually exits the kernel
+	if (boot(BACKING_STORE) != 0) { // Performs the commands necessary before starting the kernel
+		printf("Error: The backing store '%s' could not be created\n", BACKING_STORE);
+		return 1;
+	}
+	if (listenPath != NULL) {
+		error += serve(listenPath); // Serves shell sessions until the program is interrupted
+	} else {
+		error += kernel(checkpoint); // Starts and eventually exits the kernel
+	}
 	error += shutDown(); // Performs the commands necessary after exiting the kernel
 	return error;
 }
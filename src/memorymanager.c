@@ -10,9 +10,24 @@
 #include "memorymanager.h"
 #include "cpu.h"
 #include "kernel.h"
-
-int lastPID = 0; // Last process ID
-enum { BUFFER_SIZE = 50 }; // The buffer size for a page name
+#include "tlb.h"
+#include "probe.h"
+#include "trace.h"
+#include "jobs.h" // For jobMatches()
+
+KERNEL_STATE int lastPID = 0; // Last process ID
+KERNEL_STATE int lastImage = 0; // Last script image ID
+KERNEL_STATE int replacementPolicy = GLOBAL_REPLACEMENT; // Whether a process that needs a frame can take it from any process or only from itself
+KERNEL_STATE int staticQuota = 0; // The number of frames each process may hold with local replacement, or 0 for quotas proportional to the size of the scripts
+KERNEL_STATE int lowWatermark = 0; // The page daemon runs when fewer than lowWatermark frames are free, or never if it is 0
+KERNEL_STATE int highWatermark = 0; // The number of free frames the page daemon reclaims up to
+KERNEL_STATE struct LaunchRequest *pendingLaunches = NULL; // The requests of the last launchScripts() call, while some of their processes are not admitted
+KERNEL_STATE int pendingLaunchCount = 0; // The number of requests in pendingLaunches
+KERNEL_STATE int admittedLaunches = 0; // The number of requests in pendingLaunches whose processes were admitted, in order
+enum { BUFFER_SIZE = BACKING_STORE_SIZE + 50 }; // The buffer size for a page name
+
+KERNEL_STATE struct ScriptImage *imageCache = NULL; // The image cache, allocated by allocateImageCache() when the kernel boots
+KERNEL_STATE int imageCacheCount = 0; // The number of images in the image cache
 
 // A helper function that rounds up a double to an int
 int roundUp(double d) {
@@ -28,17 +43,26 @@ int roundUp(double d) {
 }
 
 // Counts the total number of pages that a file f must be split into
-int countTotalPages(FILE *f) {
+// The contents of the file are also hashed (FNV-1a) into hash and counted into size, which identifies the script in the image cache
+int countTotalPages(FILE *f, unsigned long *hash, long *size) {
     char c = '\0';
     char beforeEOF = '\0';
     int count = 0;
 
+    *hash = 14695981039346656037UL;
+    *size = 0;
+
     while (c != EOF) {
         beforeEOF = c;
         c = getc(f);
         if (c == '\n') {
             count++;
         }
+
+        if (c != EOF) {
+            *hash = (*hash ^ (unsigned char) c) * 1099511628211UL;
+            (*size)++;
+        }
     }
     
     if (beforeEOF != '\n') count++; // Because the last line did not end with a '\n'
@@ -48,10 +72,79 @@ int countTotalPages(FILE *f) {
     return total;
 }
 
-// Loads the page "[PID].[pageNumber].txt" into the frame [frameNumber] in RAM
-void loadPage(int pageNumber, int PID, int frameNumber) {
+// Remembers that a script with the given contents was split into pages under the image ID image
+// If bytecode is not NULL, the pages of the image are loaded from that compiled script instead of page files
+// Returns 0, or -1 if the cache is full
+int addImage(unsigned long hash, long size, int image, struct Bytecode *bytecode) {
+    if (imageCacheCount == IMAGE_CACHE_SIZE) {
+        return -1; // The cache is full, so the script will be split again the next time it is launched
+    }
+
+    imageCache[imageCacheCount].hash = hash;
+    imageCache[imageCacheCount].size = size;
+    imageCache[imageCacheCount].image = image;
+    imageCache[imageCacheCount].bytecode = bytecode;
+    imageCacheCount++;
+    return 0;
+}
+
+// Returns the compiled script that the pages of image are loaded from, or NULL if they are page files
+struct Bytecode *findImageBytecode(int image) {
+    int i;
+    for (i = 0; i < imageCacheCount; i++) {
+        if (imageCache[i].image == image) {
+            return imageCache[i].bytecode;
+        }
+    }
+
+    return NULL;
+}
+
+// Loads page pageNumber of the compiled script bc into the frame [frameNumber] in RAM
+// The lines are the same as in a page file: the last line of the page does not end with a new line character
+void loadCompiledPage(struct Bytecode *bc, int pageNumber, int frameNumber) {
+    uint32_t position = firstInstruction(bc, pageNumber);
+    int lines = (int) bc->header->lineCount - pageNumber * PAGE_SIZE;
+    char buffer[INSTRUCTION_SIZE];
+
+    int k;
+    for (k = 0; k < PAGE_SIZE; k++) {
+        if (k < lines) {
+            formatInstruction(bc, &position, buffer, INSTRUCTION_SIZE, k == PAGE_SIZE - 1);
+        } else {
+            buffer[0] = '\0';
+        }
+
+        if (buffer[0] == '\0') { // Nothing would be written to a page file, so end of file
+            setRamLine(frameNumber * PAGE_SIZE + k, NULL);
+            break;
+        }
+
+        setRamLine(frameNumber * PAGE_SIZE + k, buffer);
+    }
+}
+
+// Loads the page "[image].[pageNumber].txt" into the frame [frameNumber] in RAM
+// If the image was launched from a compiled script, the page is read from the compiled script instead
+// The synthetic images of the simulator (negative image IDs) have no instructions, so their frames are left empty
+void loadPage(int pageNumber, int image, int frameNumber) {
+    PROBE(PROBE_LOAD_PAGE);
+    if (image < 0) {
+        int k;
+        for (k = 0; k < PAGE_SIZE; k++) {
+            setRamLine(frameNumber * PAGE_SIZE + k, NULL);
+        }
+        return;
+    }
+
+    struct Bytecode *bc = findImageBytecode(image);
+    if (bc != NULL) {
+        loadCompiledPage(bc, pageNumber, frameNumber);
+        return;
+    }
+
     char pageName[BUFFER_SIZE];
-    snprintf(pageName, BUFFER_SIZE, "BackingStore/%d.%d.txt", PID, pageNumber);
+    snprintf(pageName, BUFFER_SIZE, "%s/%d.%d.txt", backingStore, image, pageNumber);
     FILE *pageToLoad = fopen(pageName, "r");
 
     char buffer[INSTRUCTION_SIZE];
@@ -60,13 +153,15 @@ void loadPage(int pageNumber, int PID, int frameNumber) {
 	for (k = 0; k < PAGE_SIZE; k++) {
 		strcpy(buffer, "\0"); // Clear buffer
 		fgets(buffer, INSTRUCTION_SIZE - 1, pageToLoad);
-		ram[frameNumber * PAGE_SIZE + k] = strdup(buffer);
+		setRamLine(frameNumber * PAGE_SIZE + k, buffer);
 		
 		if (strcmp(buffer, "\0") == 0) { // Nothing was written to the buffer, so end of file
-			ram[frameNumber * PAGE_SIZE + k] = NULL;
+			setRamLine(frameNumber * PAGE_SIZE + k, NULL);
 			break;
 		}
     }
+
+    fclose(pageToLoad);
 }
 
 // Looks for an available frame in RAM
@@ -74,90 +169,175 @@ void loadPage(int pageNumber, int PID, int frameNumber) {
 // Otherwise, error code -1 is returned
 int findFrame() {
     int i;
-    for (i = 0; i < RAM_SIZE; i += PAGE_SIZE) { // Traverse the RAM frame by frame
-        if (ram[i] == NULL) {
-            return i / PAGE_SIZE;
+    for (i = 0; i < FRAME_COUNT; i++) { // Traverse the frame table
+        if (frameTable[i].image == FREE_FRAME) {
+            return i;
         }
     }
 
     return -1;
 }
 
-// If there is no available frame in RAM, this function is called to find a victim frame to overwrite
-int findVictim(struct PCB *p) {
-    int victim = rand() % (RAM_SIZE / PAGE_SIZE);
+// Looks for a frame in RAM that already holds page pageNumber of the script image image
+// If a frame is found, the frame number is returned
+// Otherwise, -1 is returned
+int findSharedFrame(int image, int pageNumber) {
+    int i;
+    for (i = 0; i < FRAME_COUNT; i++) {
+        if (frameTable[i].image == image && frameTable[i].page == pageNumber) {
+            return i;
+        }
+    }
 
+    return -1;
+}
+
+// Returns 1 if the page table of PCB p points to frame frameNumber, and 0 otherwise
+int mapsFrame(struct PCB *p, int frameNumber) {
     int i;
-    int tryAgain = 1;
-    int counter = 0;
+    for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+        if ((p->pageTable)[i] == frameNumber) {
+            return 1;
+        }
+    }
 
-    while (tryAgain) {
-        tryAgain = 0;
-        victim = victim % (RAM_SIZE / PAGE_SIZE);
-        victim++;
+    return 0;
+}
 
-        // Traverse the page table
-        for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
-            // If the victim fram selected is used by the current PCB (the one passed in as a parameter),
-            // then another victim frame needs to be selected
-            if ((p->pageTable)[i] == victim) {
-                tryAgain = 1;
+// Returns the number of frames PCB p may hold with local replacement
+// The quota is either the same for every process (staticQuota) or proportional to the number of pages
+// of the script, relative to the scripts of all processes, with a minimum of one frame
+int frameQuota(struct PCB *p) {
+    if (staticQuota > 0) {
+        return staticQuota;
+    }
+
+    int totalPages = 0;
+    struct PCB *q;
+    for (q = processList; q != NULL; q = q->nextProcess) {
+        totalPages += q->pages_max;
+    }
+
+    int quota = totalPages == 0 ? FRAME_COUNT : FRAME_COUNT * p->pages_max / totalPages;
+    return quota < 1 ? 1 : quota;
+}
+
+// With local replacement, finds the frame that PCB p should give up to load another of its pages
+// A frame that no other process shares is preferred
+// Returns -1 if p does not hold any frame
+int findLocalVictim(struct PCB *p) {
+    int start = rand() % FRAME_COUNT;
+    int victim = -1;
+
+    int i;
+    for (i = 0; i < FRAME_COUNT; i++) {
+        int frame = (start + i) % FRAME_COUNT;
+        if (mapsFrame(p, frame)) {
+            if (frameTable[frame].refs == 1) {
+                return frame;
             }
+            victim = frame;
         }
+    }
 
-        if (counter > RAM_SIZE / PAGE_SIZE) {
-            return -1; // Error: The program had more than RAM_SIZE / PAGE_SIZE pages, which is not supported
+    return victim;
+}
+
+// If there is no available frame in RAM, this function is called to find a victim frame to overwrite
+// A frame that no process maps anymore is preferred, since evicting it does not cause page faults.
+// With local replacement, a frame of a process that holds more than its quota is preferred next.
+// Otherwise, a random frame that is not used by PCB p is selected.
+int findVictim(struct PCB *p) {
+    PROBE(PROBE_FIND_VICTIM);
+    int start = rand() % FRAME_COUNT;
+
+    int i;
+    for (i = 0; i < FRAME_COUNT; i++) {
+        int victim = (start + i) % FRAME_COUNT;
+        if (frameTable[victim].refs == 0) {
+            return victim;
         }
+    }
 
-        counter++;
+    if (replacementPolicy == LOCAL_REPLACEMENT) {
+        struct PCB *q;
+        for (q = processList; q != NULL; q = q->nextProcess) {
+            if (q != p && residentPages(q) > frameQuota(q)) {
+                int victim = findLocalVictim(q);
+                if (victim != -1 && !mapsFrame(p, victim)) {
+                    return victim;
+                }
+            }
+        }
     }
 
-    return victim;
+    for (i = 0; i < FRAME_COUNT; i++) {
+        int victim = (start + i) % FRAME_COUNT;
+        // If the victim frame selected is used by the current PCB (the one passed in as a parameter),
+        // then another victim frame needs to be selected
+        if (!mapsFrame(p, victim)) {
+            return victim;
+        }
+    }
+
+    return -1; // Error: every frame is used by PCB p
 }
 
 // This function has a different behavior depending on whether the frame corresponding to frameNumber is a victim frame
 // If victimFrame is equal to 1, then it is a victim frame. Otherwise, it is not.
 //
 // If the frame is not a victim, this function updates the page table of PCB p so that pageNumber is associated with frameNumber
-// If the frame is a victim, this function also updates the page table of the PCB that owns the victim frame to indicate that it no longer owns the frame
+// If the frame is a victim, this function also updates the page tables of every PCB that shares the victim frame to indicate that they no longer own the frame
 int updatePageTable(struct PCB *p, int pageNumber, int frameNumber, int victimFrame) {
+    PROBE(PROBE_UPDATE_PAGE_TABLE);
+
     if (victimFrame) { // If the frame is a victim
-        // Traverse the page table of all PCBs in the ready queue to find the PCB that is the owner of the victim frame
-        struct PCB *victimPCB = NULL;
-        int victimPageNumber = -1;
-        struct ReadyQueue *node = head;
-        while (node != NULL) {
+        // Traverse the page table of all PCBs in the process list to find the PCBs that share the victim frame
+        struct PCB *victimPCB;
+        for (victimPCB = processList; victimPCB != NULL; victimPCB = victimPCB->nextProcess) {
             int i;
             for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
-                if (node->pcb->pageTable[i] == frameNumber) {
-                    victimPCB = node->pcb;
-                    victimPageNumber = i;
-                    break;
+                if (victimPCB->pageTable[i] == frameNumber) {
+                    victimPCB->pageTable[i] = -1; // Page i is no longer associated with frameNumber since the frame was taken by another PCB
                 }
             }
-            node = node->next;
-        }
-
-        if (victimPageNumber == -1) {
-            return -1; // Error
         }
 
-        // Update the victim PCB's page table
-        victimPCB->pageTable[victimPageNumber] = -1; // victimPageNumber is no longer associated with frameNumber since the frame was taken by another PCB
+        frameTable[frameNumber].refs = 0;
+        invalidateTLBFrame(frameNumber); // The TLB must not translate to the old page anymore
     }
 
     // Update the current PCB's page table
     p->pageTable[pageNumber] = frameNumber; // pageNumber is now associated with frameNumber
+    frameTable[frameNumber].image = p->image;
+    frameTable[frameNumber].page = pageNumber;
+    frameTable[frameNumber].refs++;
     
     return frameNumber;
 }
 
 // Finds an available or victim frame, loads the page that corresponds with pageNumber to the frame, and updates the page table
-int findLoadUpdate(struct PCB *pcb, int pageNumber, int PID) {
-    // Find a frame
-    int frame = findFrame();
+// If another process running the same image already has the page in a frame, that frame is shared instead
+int findLoadUpdate(struct PCB *pcb, int pageNumber) {
+    // Look for a frame that already holds the page
+    int frame = findSharedFrame(pcb->image, pageNumber);
+    if (frame != -1) {
+        updatePageTable(pcb, pageNumber, frame, 0);
+        traceFault(pcb, pageNumber, frame);
+        return 0; // No error
+    }
+
     int victim = 0;
 
+    if (replacementPolicy == LOCAL_REPLACEMENT && residentPages(pcb) >= frameQuota(pcb)) {
+        // The process has used up its quota, so it replaces one of its own pages
+        frame = findLocalVictim(pcb);
+        victim = 1;
+    } else {
+        // Find a frame
+        frame = findFrame();
+    }
+
     if (frame == -1) {
         // Find a victim frame
         frame = findVictim(pcb);
@@ -168,67 +348,401 @@ int findLoadUpdate(struct PCB *pcb, int pageNumber, int PID) {
         return -1; // Error
     }
 
+    if (victim) {
+        vmstats.directReclaims++; // The frame was reclaimed on the critical path of the fault
+    }
+
     // Load page to frame
-    loadPage(pageNumber, PID, frame);
+    loadPage(pageNumber, pcb->image, frame);
 
     // Update page table
     updatePageTable(pcb, pageNumber, frame, victim);
+    traceFault(pcb, pageNumber, frame);
 
     return 0; // No error
 }
 
-// Opens the file filename, stores it in the backing store as multiple pages, creates a PCB for the file, and loads one or more pages into RAM
-int launcher(char *filename) {
-    FILE* originalFile = fopen(filename, "r");
-    int pages_max = countTotalPages(originalFile);
-    fclose(originalFile);
+// Swaps out every page of PCB pcb: its page table is cleared, and the frames that no other process maps become free
+void releaseFrames(struct PCB *pcb) {
+    int i;
+    for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+        int frame = pcb->pageTable[i];
+        if (frame == -1) {
+            continue;
+        }
+
+        pcb->pageTable[i] = -1;
+        if (frameTable[frame].refs > 0) {
+            frameTable[frame].refs--;
+        }
 
-    if (pages_max > RAM_SIZE / PAGE_SIZE) {
-        return -1; // Error: script has too many instructions
+        if (frameTable[frame].refs == 0) {
+            frameTable[frame].image = FREE_FRAME;
+            frameTable[frame].page = -1;
+            int k;
+            for (k = 0; k < PAGE_SIZE; k++) {
+                setRamLine(frame * PAGE_SIZE + k, NULL);
+            }
+            invalidateTLBFrame(frame);
+        }
     }
+}
 
-    originalFile = fopen(filename, "r");
-    
+// Counts the number of frames in RAM that do not hold a page
+int countFreeFrames() {
+    int count = 0;
+    int i;
+    for (i = 0; i < FRAME_COUNT; i++) { // Traverse the frame table
+        if (frameTable[i].image == FREE_FRAME) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Frees frame frameNumber: every page table that maps it is cleared, and it no longer holds a page
+void evictFrame(int frameNumber) {
+    struct PCB *p;
+    for (p = processList; p != NULL; p = p->nextProcess) {
+        int i;
+        for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+            if (p->pageTable[i] == frameNumber) {
+                p->pageTable[i] = -1;
+            }
+        }
+    }
+
+    frameTable[frameNumber].image = FREE_FRAME;
+    frameTable[frameNumber].page = -1;
+    frameTable[frameNumber].refs = 0;
+    int k;
+    for (k = 0; k < PAGE_SIZE; k++) {
+        setRamLine(frameNumber * PAGE_SIZE + k, NULL);
+    }
+    invalidateTLBFrame(frameNumber);
+}
+
+// Finds the coldest frame that holds a page, which the page daemon evicts first
+// A frame that no process maps is the coldest. Otherwise, the frame whose page was dispatched least recently
+// by any of the processes that map it is chosen; a page that was loaded but never dispatched counts as
+// dispatched at tick now, so that the pages preloaded for a new process are not evicted before it runs.
+// Returns -1 if every frame is free
+int findColdFrame(int now) {
+    int coldest = -1;
+    int coldestUse = 0;
+
+    int i;
+    for (i = 0; i < FRAME_COUNT; i++) {
+        if (frameTable[i].image == FREE_FRAME) {
+            continue;
+        }
+        if (frameTable[i].refs == 0) {
+            return i;
+        }
+
+        int lastUse = -1; // The last dispatch of the page by any process that maps it
+        struct PCB *p;
+        for (p = processList; p != NULL; p = p->nextProcess) {
+            int page = frameTable[i].page;
+            if (page < RAM_SIZE / PAGE_SIZE && p->pageTable[page] == i) {
+                int use = p->lastUse[page] == -1 ? now : p->lastUse[page];
+                if (use > lastUse) {
+                    lastUse = use;
+                }
+            }
+        }
+
+        if (coldest == -1 || lastUse < coldestUse) {
+            coldest = i;
+            coldestUse = lastUse;
+        }
+    }
+
+    return coldest;
+}
+
+// Runs the page daemon at scheduler tick now
+// When fewer than lowWatermark frames are free, the coldest frames are evicted until highWatermark frames are free,
+// so that page faults find a free frame with findFrame() instead of searching for a victim.
+// Returns the number of frames reclaimed
+int pageDaemon(int now) {
+    if (lowWatermark == 0) {
+        return 0;
+    }
+
+    int freeFrames = countFreeFrames();
+    if (freeFrames >= lowWatermark) {
+        return 0;
+    }
+
+    vmstats.daemonRuns++;
+    int reclaimed = 0;
+    while (freeFrames < highWatermark) {
+        int frame = findColdFrame(now);
+        if (frame == -1) {
+            break;
+        }
+
+        evictFrame(frame);
+        freeFrames++;
+        reclaimed++;
+    }
+
+    vmstats.daemonReclaims += reclaimed;
+    return reclaimed;
+}
+
+// Decides how many pages of a script with pages_max pages to load into RAM when it is launched
+// The free frames are shared evenly between the scripts that are still being launched (scriptsLeft, including this one),
+// so idle RAM is filled eagerly, and only the first page is loaded when RAM is full
+int countPagesToLoad(int pages_max, int scriptsLeft) {
+    if (scriptsLeft < 1) {
+        scriptsLeft = 1;
+    }
+
+    int share = countFreeFrames() / scriptsLeft;
+    if (share < 1) {
+        share = 1; // The first page must always be loaded, even if it requires a victim frame
+    }
+
+    return share < pages_max ? share : pages_max;
+}
+
+// Copies the next page of the script originalFile to target: up to PAGE_SIZE lines, without the new line character
+// of the last line of the page
+void copyPage(FILE *originalFile, FILE *target) {
     char c = '\0';
+    int i;
+    for (i = 0; i < PAGE_SIZE; i++) {
+        do {
+            c = fgetc(originalFile);
+            if (c != EOF) { // Do not add the EOF to the file
+                if (i != PAGE_SIZE - 1 || c != '\n') { // Do not add the '\n' for the last line
+                    fputc(c, target);
+                }
+            }
+        } while (c != '\n' && c != EOF);
+
+        if (c == EOF) {
+            break;
+        }
+    }
+}
+
+// Splits the file filename into pages_max pages named "[image].[pageNumber].txt" in the backing store directory
+void splitScript(char *filename, int pages_max, int image, const char *directory) {
+    FILE *originalFile = fopen(filename, "r");
+
     char newName[BUFFER_SIZE] = "";
     int pageCount = 0;
-    lastPID++;
 
     while (pageCount < pages_max) {
-        snprintf(newName, BUFFER_SIZE, "BackingStore/%d.%d.txt", lastPID, pageCount++);
+        snprintf(newName, BUFFER_SIZE, "%s/%d.%d.txt", directory, image, pageCount++);
         FILE *target = fopen(newName, "w");
-        int i;
-        for (i = 0; i < PAGE_SIZE; i++) {
-            do {
-                c = fgetc(originalFile);
-                if (c != EOF) { // Do not add the EOF to the file
-                    if (i != PAGE_SIZE - 1 || c != '\n') { // Do not add the '\n' for the last line
-                        fputc(c, target);
-                    }
-		        }
-            } while (c != '\n' && c != EOF);
-            
-            if (c == EOF) {
-                break;
-            }
-        }
+        copyPage(originalFile, target);
         fclose(target);
     }
 
     fclose(originalFile);
+}
+
+// Writes page pageNumber of the compiled script bc to target, as it would be stored in a page file
+void writeCompiledPage(struct Bytecode *bc, int pageNumber, FILE *target) {
+    char buffer[INSTRUCTION_SIZE];
+    int lineCount = (int) bc->header->lineCount;
+    uint32_t position = firstInstruction(bc, pageNumber);
+
+    int k;
+    for (k = 0; k < PAGE_SIZE && pageNumber * PAGE_SIZE + k < lineCount; k++) {
+        formatInstruction(bc, &position, buffer, INSTRUCTION_SIZE, k == PAGE_SIZE - 1);
+        fputs(buffer, target);
+    }
+}
+
+// Writes the pages_max pages of the compiled script bc as page files named "[image].[pageNumber].txt" in the backing store directory
+void writeCompiledPages(struct Bytecode *bc, int pages_max, int image, const char *directory) {
+    char newName[BUFFER_SIZE] = "";
+
+    int page;
+    for (page = 0; page < pages_max; page++) {
+        snprintf(newName, BUFFER_SIZE, "%s/%d.%d.txt", directory, image, page);
+        FILE *target = fopen(newName, "w");
+        writeCompiledPage(bc, page, target);
+        fclose(target);
+    }
+}
+
+// Writes page pageNumber of the image image to target, as it is stored in the backing store
+void writeImagePage(int image, int pageNumber, FILE *target) {
+    struct Bytecode *bc = findImageBytecode(image);
+    if (bc != NULL) {
+        writeCompiledPage(bc, pageNumber, target);
+        return;
+    }
+
+    char pageName[BUFFER_SIZE];
+    snprintf(pageName, BUFFER_SIZE, "%s/%d.%d.txt", backingStore, image, pageNumber);
+    FILE *page = fopen(pageName, "r");
+    if (page == NULL) {
+        return;
+    }
+
+    char buffer[BUFSIZ];
+    size_t length;
+    while ((length = fread(buffer, 1, BUFSIZ, page)) > 0) {
+        fwrite(buffer, 1, length, target);
+    }
+    fclose(page);
+}
+
+// Returns 1 if the pages of the script of a scanned launch request are identical, byte for byte, to the pages of
+// the image image, and 0 otherwise
+// The hash and the size of the contents only find the candidate images quickly: a script only shares an image
+// once its pages were compared, so that two scripts whose hashes collide never share frames.
+int sameImage(struct LaunchRequest *request, int image) {
+    FILE *originalFile = NULL;
+    if (request->bytecode == NULL && (originalFile = fopen(request->filename, "r")) == NULL) {
+        return 0;
+    }
+
+    int same = 1;
+    int page;
+    for (page = 0; page < request->pages_max && same; page++) {
+        char *expected = NULL;
+        char *actual = NULL;
+        size_t expectedSize = 0;
+        size_t actualSize = 0;
+        FILE *expectedPage = open_memstream(&expected, &expectedSize);
+        FILE *actualPage = open_memstream(&actual, &actualSize);
+
+        writeImagePage(image, page, expectedPage);
+        if (request->bytecode != NULL) {
+            writeCompiledPage(request->bytecode, page, actualPage);
+        } else {
+            copyPage(originalFile, actualPage);
+        }
 
-    int numberOfPagesToLoad;
-    if (pages_max > 2) {
-        numberOfPagesToLoad = 2;
+        fclose(expectedPage);
+        fclose(actualPage);
+        same = expectedSize == actualSize && memcmp(expected, actual, actualSize) == 0;
+        free(expected);
+        free(actual);
+    }
+
+    if (originalFile != NULL) {
+        fclose(originalFile);
+    }
+    return same;
+}
+
+// Scans the script of a launch request: counts its pages and hashes its contents
+// A compiled script is not scanned: it is mapped, and its header describes its source.
+// This does not use the state of the kernel, so it can be executed by a worker thread.
+// request->error is set to -1 if the script has too many instructions, and to -3 if it is not a valid compiled script.
+void scanScript(void *argument) {
+    struct LaunchRequest *request = (struct LaunchRequest *) argument;
+    request->bytecode = NULL;
+
+    if (isBytecodeFile(request->filename)) {
+        int error;
+        struct Bytecode *bc = mapBytecode(request->filename, &error);
+        if (bc == NULL) {
+            request->error = -3; // Error: not a valid compiled script
+            return;
+        }
+
+        // The compiled script identifies its source, so it shares an image with it
+        request->pages_max = (int) bc->header->pageCount;
+        request->hash = (unsigned long) bc->header->sourceHash;
+        request->size = (long) bc->header->sourceSize;
+        request->bytecode = bc;
     } else {
-        numberOfPagesToLoad = pages_max;
+        FILE* originalFile = fopen(request->filename, "r");
+        request->pages_max = countTotalPages(originalFile, &request->hash, &request->size);
+        fclose(originalFile);
+    }
+
+    if (request->pages_max > RAM_SIZE / PAGE_SIZE) {
+        if (request->bytecode != NULL) {
+            unmapBytecode(request->bytecode);
+        }
+        request->error = -1; // Error: script has too many instructions
+        return;
     }
 
-    struct PCB *pcb = initPCB(lastPID, pages_max);
+    request->error = 0;
+}
+
+// Looks for the image of a scanned script in the image cache: an image with the same hash and size, whose pages
+// are identical to the pages of the script
+// If it is found, its image ID is returned
+// Otherwise, -1 is returned
+int findImage(struct LaunchRequest *request) {
+    int i;
+    for (i = 0; i < imageCacheCount; i++) {
+        if (imageCache[i].hash == request->hash && imageCache[i].size == request->size && sameImage(request, imageCache[i].image)) {
+            return imageCache[i].image;
+        }
+    }
+
+    return -1;
+}
+
+// Finds the image of a scanned script in the image cache, or reserves a new image that the script must be split into
+// The images are reserved in the order of the requests, so that identical scripts launched together share an image.
+void reserveImage(struct LaunchRequest *request) {
+    request->image = findImage(request);
+    request->mustSplit = request->image == -1;
+    request->directory = backingStore;
+
+    if (request->mustSplit) {
+        request->image = ++lastImage;
+        if (addImage(request->hash, request->size, request->image, request->bytecode) == 0 && request->bytecode != NULL) {
+            request->mustSplit = 0; // The image keeps the compiled script mapped and loads its pages from it
+            request->bytecode = NULL;
+        }
+    }
+}
+
+// Splits the script of a launch request into pages in the backing store, if its image was not split already
+// Like scanScript(), this can be executed by a worker thread.
+void splitImage(void *argument) {
+    struct LaunchRequest *request = (struct LaunchRequest *) argument;
+
+    if (request->mustSplit) {
+        if (request->bytecode != NULL) {
+            writeCompiledPages(request->bytecode, request->pages_max, request->image, request->directory);
+        } else {
+            splitScript(request->filename, request->pages_max, request->image, request->directory);
+        }
+    }
+
+    if (request->bytecode != NULL) {
+        unmapBytecode(request->bytecode);
+        request->bytecode = NULL;
+    }
+}
+
+// Admits a prepared launch request whose PID was already assigned: creates its PCB, adds it to the ready queue
+// and loads one or more of its pages into RAM
+// scriptsLeft is the number of scripts that are still being launched by the same command, including this one
+// Returns 0, or -2 if a victim frame could not be found
+int admitScript(struct LaunchRequest *request, int scriptsLeft) {
+    int numberOfPagesToLoad = countPagesToLoad(request->pages_max, scriptsLeft);
+
+    struct PCB *pcb = initPCB(request->PID, request->pages_max);
+    pcb->image = request->image;
+    pcb->job = request->job;
+    request->pcb = pcb;
+
+    if (replacementPolicy == LOCAL_REPLACEMENT && numberOfPagesToLoad > frameQuota(pcb)) {
+        numberOfPagesToLoad = frameQuota(pcb); // Loading more pages than the quota would only replace the first pages
+    }
 
     int i;
     for (i = 0; i < numberOfPagesToLoad; i++) { 
-        int tag = findLoadUpdate(pcb, i, lastPID);
+        int tag = findLoadUpdate(pcb, i);
         if (tag == -1) {
             return -2; // Error: could not find victim
         }
@@ -236,3 +750,199 @@ int launcher(char *filename) {
 
     return 0; // No error
 }
+
+// Creates a PCB for a prepared launch request, and loads one or more of its pages into RAM
+// scriptsLeft is the number of scripts that are still being launched by the same command, including this one
+// Returns 0, or -2 if a victim frame could not be found
+int commitScript(struct LaunchRequest *request, int scriptsLeft) {
+    lastPID++;
+    request->PID = lastPID;
+    return admitScript(request, scriptsLeft);
+}
+
+// Creates a process that runs the same image as PCB parent, in the same job, and adds it to the ready queue
+// The child starts at the first instruction of the script, and its page table points to the frames of parent, so
+// no page is read from the backing store: creating it costs the same whatever the size of the script, and the
+// frames stay shared until one of the processes takes a page fault.
+struct PCB *cloneProcess(struct PCB *parent) {
+    lastPID++;
+
+    struct PCB *child = initPCB(lastPID, parent->pages_max);
+    child->image = parent->image;
+    child->job = parent->job;
+
+    int i;
+    for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+        int frame = parent->pageTable[i];
+        if (frame != -1) {
+            child->pageTable[i] = frame;
+            frameTable[frame].refs++;
+        }
+    }
+
+    return child;
+}
+
+// Opens the file filename, stores it in the backing store as multiple pages, creates a PCB for the file, and loads one or more pages into RAM
+// scriptsLeft is the number of scripts that are still being launched by the same command, including this one
+int launcher(char *filename, int scriptsLeft) {
+    struct LaunchRequest request = { .filename = filename, .job = 0 };
+    scanScript(&request);
+    if (request.error != 0) {
+        return request.error;
+    }
+
+    reserveImage(&request);
+    splitImage(&request);
+
+    return commitScript(&request, scriptsLeft);
+}
+
+// Launches several scripts at once
+// The scripts are scanned in parallel by the thread pool, so that a script that cannot be launched stops the command
+// before any process is created. Their PIDs are assigned and their images reserved in order, and the new images are
+// split in parallel. The first process is admitted as soon as its image is split, and it starts running while the
+// other images are still being split: admitLaunches() admits the other processes at the end of the next quantum,
+// before the process that ran returns to the ready queue, so the processes run in the same order as if launcher()
+// was called for each script.
+// The requests must stay valid until admitLaunches() has returned.
+// Returns the index of the first request that could not be launched (its error is in requests[i].error), or -1.
+int launchScripts(struct LaunchRequest requests[], int count) {
+    int i;
+    for (i = 0; i < count; i++) {
+        submitTask(&requests[i].task, scanScript, &requests[i]);
+    }
+
+    for (i = 0; i < count; i++) {
+        waitTask(&requests[i].task);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (requests[i].error != 0) {
+            int j;
+            for (j = 0; j < count; j++) {
+                if (requests[j].error == 0 && requests[j].bytecode != NULL) {
+                    unmapBytecode(requests[j].bytecode);
+                }
+            }
+            return i;
+        }
+    }
+
+    if (pendingLaunches != NULL) { // The script is launched by a process of a launch that is still pending
+        admitLaunches();
+    }
+
+    for (i = 0; i < count; i++) {
+        int j;
+        for (j = 0; j < i; j++) { // The pages of an image that may be shared must be written before they are compared
+            if (requests[j].mustSplit && requests[j].hash == requests[i].hash && requests[j].size == requests[i].size) {
+                waitTask(&requests[j].task);
+            }
+        }
+        reserveImage(&requests[i]);
+        submitTask(&requests[i].task, splitImage, &requests[i]);
+        lastPID++;
+        requests[i].PID = lastPID;
+        requests[i].killed = 0;
+    }
+
+    waitTask(&requests[0].task);
+    requests[0].error = admitScript(&requests[0], count);
+
+    pendingLaunches = requests;
+    pendingLaunchCount = count;
+    admittedLaunches = 1;
+    if (requests[0].error != 0) {
+        killLaunches(requests[0].job);
+    }
+    if (requests[0].error != 0 || count == 1) {
+        admitLaunches(); // Nothing is left to admit
+    }
+
+    return requests[0].error != 0 ? 0 : -1;
+}
+
+// Admits the processes of the last launchScripts() call that are not admitted yet, in order: waits until their
+// images are split, adds them to the ready queue and loads their first pages
+// This is done between two quanta, so loading the pages never takes a frame from the process that is running.
+void admitLaunches() {
+    while (admittedLaunches < pendingLaunchCount) {
+        struct LaunchRequest *request = &pendingLaunches[admittedLaunches];
+        waitTask(&request->task);
+        if (!request->killed) {
+            admitScript(request, pendingLaunchCount - admittedLaunches); // A page that cannot be loaded faults when it is executed
+        }
+        admittedLaunches++;
+    }
+
+    pendingLaunches = NULL;
+    pendingLaunchCount = 0;
+    admittedLaunches = 0;
+}
+
+// Prevents the processes of the job with ID job (or of every job of the current owner if job is ALL_JOBS) that are
+// not admitted yet from being admitted
+// Returns the number of processes killed
+int killLaunches(int job) {
+    int count = 0;
+    int i;
+    for (i = admittedLaunches; i < pendingLaunchCount; i++) {
+        if (!pendingLaunches[i].killed && jobMatches(pendingLaunches[i].job, job)) {
+            pendingLaunches[i].killed = 1;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Waits until the images of the processes that are not admitted yet are split, so that the backing store holds
+// their pages
+void waitForLaunchImages() {
+    int i;
+    for (i = admittedLaunches; i < pendingLaunchCount; i++) {
+        waitTask(&pendingLaunches[i].task);
+    }
+}
+
+// Writes the pages of every image that is loaded from a compiled script as page files in the backing store,
+// so that the backing store holds the pages of every image (for example, to save a checkpoint)
+void materializeImages() {
+    int i;
+    for (i = 0; i < imageCacheCount; i++) {
+        struct Bytecode *bc = imageCache[i].bytecode;
+        if (bc != NULL) {
+            writeCompiledPages(bc, (int) bc->header->pageCount, imageCache[i].image, backingStore);
+            unmapBytecode(bc);
+            imageCache[i].bytecode = NULL;
+        }
+    }
+}
+
+// Allocates the empty image cache on the heap, rather than in the thread-local state of the kernel
+// Returns 0, or -1 if it could not be allocated
+int allocateImageCache() {
+    imageCache = (struct ScriptImage *) calloc(IMAGE_CACHE_SIZE, sizeof(struct ScriptImage));
+    imageCacheCount = 0;
+    return imageCache != NULL ? 0 : -1;
+}
+
+// Frees the image cache, once its images have been unmapped
+void freeImageCache() {
+    free(imageCache);
+    imageCache = NULL;
+}
+
+// Unmaps the compiled scripts of every image and empties the image cache, which is done when the backing store
+// that holds the images is discarded
+void unmapImages() {
+    int i;
+    for (i = 0; i < imageCacheCount; i++) {
+        if (imageCache[i].bytecode != NULL) {
+            unmapBytecode(imageCache[i].bytecode);
+            imageCache[i].bytecode = NULL;
+        }
+    }
+    imageCacheCount = 0;
+}
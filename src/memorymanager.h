@@ -6,10 +6,71 @@
 #define MEMORYMANAGER_H
 
 #include "pcb.h" // For struct PCB
+#include "threadpool.h" // For struct Task
+#include "bytecode.h" // For struct Bytecode
 
-int lastPID;
+enum {
+    IMAGE_CACHE_SIZE = 100 // The number of script images that can be remembered by the image cache
+};
 
-int findLoadUpdate(struct PCB *pcb, int pageNumber, int PID);
-int launcher(char *filename);
+// A structure that remembers a script that was split into pages in the backing store
+// Scripts with identical contents are split only once, and every process running them shares the same image
+struct ScriptImage {
+    unsigned long hash; // The hash of the contents of the script
+    long size; // The number of characters in the script
+    int image; // The image ID, which names the page files "[image].[pageNumber].txt" in the backing store
+    struct Bytecode *bytecode; // The compiled script that the pages are loaded from, or NULL if they are page files
+};
+
+enum {
+    GLOBAL_REPLACEMENT = 0, // A process that needs a frame can take a victim frame from any other process
+    LOCAL_REPLACEMENT = 1 // A process that has used up its frame quota must replace one of its own pages
+};
+
+// A request to launch a script, used to launch several scripts in parallel
+struct LaunchRequest {
+    char *filename; // The script to launch
+    int pages_max; // The number of pages of the script
+    int image; // The image of the script in the backing store
+    int job; // The job the process will belong to
+    unsigned long hash; // The hash of the contents of the script
+    long size; // The number of characters in the script
+    struct Bytecode *bytecode; // The compiled script, while it is launched from one
+    int mustSplit; // 1 if the script must be split into pages because its image is new
+    const char *directory; // The backing store directory that the pages are written to
+    int PID; // The PID of the process, assigned when the script is launched
+    int killed; // 1 if the job of the process was killed before the process was admitted
+    struct PCB *pcb; // The PCB created for the script, once the process is admitted
+    int error; // 0 if the script was launched, -1 if it has too many instructions, -2 if a victim frame could not be found, and -3 if it is not a valid compiled script
+    struct Task task; // The task that prepares the script on the thread pool
+};
+
+extern KERNEL_STATE int lastPID;
+extern KERNEL_STATE int lastImage;
+extern KERNEL_STATE struct ScriptImage *imageCache; // An array of IMAGE_CACHE_SIZE images
+extern KERNEL_STATE int imageCacheCount;
+extern KERNEL_STATE int replacementPolicy;
+extern KERNEL_STATE int staticQuota;
+extern KERNEL_STATE int lowWatermark;
+extern KERNEL_STATE int highWatermark;
+extern KERNEL_STATE struct LaunchRequest *pendingLaunches;
+extern KERNEL_STATE int pendingLaunchCount;
+extern KERNEL_STATE int admittedLaunches;
+
+int findLoadUpdate(struct PCB *pcb, int pageNumber);
+void releaseFrames(struct PCB *pcb);
+int frameQuota(struct PCB *pcb);
+int pageDaemon(int now);
+int launcher(char *filename, int scriptsLeft);
+int commitScript(struct LaunchRequest *request, int scriptsLeft);
+struct PCB *cloneProcess(struct PCB *parent);
+int launchScripts(struct LaunchRequest requests[], int count);
+void admitLaunches();
+int killLaunches(int job);
+void waitForLaunchImages();
+int allocateImageCache();
+void freeImageCache();
+void materializeImages();
+void unmapImages();
 
 #endif
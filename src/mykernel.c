@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements the C API of libmykernel
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "mykernel.h"
+#include "kernel.h"
+#include "shell.h"
+#include "cpu.h"
+#include "jobs.h"
+#include "tlb.h"
+
+// A kernel booted by mykernelBoot()
+struct MyKernel {
+	pthread_t thread; // The thread that booted the kernel, which is the only one that can use it
+};
+
+KERNEL_STATE struct MyKernel *currentKernel = NULL; // The kernel booted by this thread, if any
+
+// Returns 1 if kernel is the kernel booted by the calling thread, and 0 otherwise
+int ownsKernel(struct MyKernel *kernel) {
+	return kernel != NULL && kernel == currentKernel && pthread_equal(kernel->thread, pthread_self());
+}
+
+// Boots a kernel for the calling thread, which stores its pages in the directory backingStore
+// The directory is created, and it is removed when the kernel is shut down.
+// Returns the kernel, or NULL if the thread already has a kernel or the kernel could not be booted
+struct MyKernel *mykernelBoot(const char *backingStore) {
+	if (currentKernel != NULL) {
+		return NULL;
+	}
+
+	struct MyKernel *kernel = (struct MyKernel *) malloc(sizeof(struct MyKernel));
+	if (kernel == NULL) {
+		return NULL;
+	}
+
+	if (boot(backingStore) != 0) { // A kernel that failed to boot has nothing to shut down
+		free(kernel);
+		return NULL;
+	}
+
+	kernel->thread = pthread_self();
+	currentKernel = kernel;
+	return kernel;
+}
+
+// Interprets and executes a command, like a line entered in the shell
+// A command that ends with '&' starts a background job, which is executed by later commands and by mykernelRun().
+// Returns 0 if the command was executed, and -1 if it failed or the kernel does not belong to the calling thread
+int mykernelSubmit(struct MyKernel *kernel, const char *command) {
+	if (!ownsKernel(kernel) || strlen(command) >= INSTRUCTION_SIZE) {
+		return -1;
+	}
+
+	char line[INSTRUCTION_SIZE];
+	strcpy(line, command);
+	int error = parse(line);
+	reportFinishedJobs();
+
+	return error;
+}
+
+// Executes the background jobs until they have all finished
+// Returns 0, or -1 if the kernel does not belong to the calling thread
+int mykernelRun(struct MyKernel *kernel) {
+	if (!hasBackgroundJobs()) {
+		return ownsKernel(kernel) ? 0 : -1;
+	}
+
+	return mykernelSubmit(kernel, "wait");
+}
+
+// Copies the statistics of a kernel into stats
+// Returns 0, or -1 if the kernel does not belong to the calling thread
+int mykernelStats(struct MyKernel *kernel, struct MyKernelStats *stats) {
+	if (!ownsKernel(kernel)) {
+		return -1;
+	}
+
+	stats->pageFaults = vmstats.pageFaults;
+	stats->suspensions = vmstats.suspensions;
+	stats->resumptions = vmstats.resumptions;
+	stats->directReclaims = vmstats.directReclaims;
+	stats->daemonReclaims = vmstats.daemonReclaims;
+	stats->tlbHits = tlb.hits;
+	stats->tlbMisses = tlb.misses;
+
+	stats->processes = 0;
+	struct PCB *pcb;
+	for (pcb = processList; pcb != NULL; pcb = pcb->nextProcess) {
+		stats->processes++;
+	}
+
+	return 0;
+}
+
+// Terminates the processes of a kernel, removes its backing store, and releases it
+// Returns 0, or a non-zero value if the kernel does not belong to the calling thread or the backing store could not be removed
+int mykernelShutdown(struct MyKernel *kernel) {
+	if (!ownsKernel(kernel)) {
+		return -1;
+	}
+
+	currentKernel = NULL;
+	free(kernel);
+
+	return shutDown();
+}
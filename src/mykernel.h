@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef MYKERNEL_H
+#define MYKERNEL_H
+
+// The C API of libmykernel, which embeds the kernel in another program
+// A kernel belongs to the thread that booted it, because its state is local to that thread. Several threads can each
+// boot and use their own kernel at the same time, as long as they give it different backing store directories.
+// The kernels print their output to the standard output of the program, like the shell.
+
+// A kernel booted by mykernelBoot()
+struct MyKernel;
+
+// The statistics of a kernel
+struct MyKernelStats {
+	long pageFaults; // The number of page faults taken by the scheduler
+	long suspensions; // The number of processes suspended by load control
+	long resumptions; // The number of processes resumed by load control
+	long directReclaims; // The number of frames reclaimed by page faults
+	long daemonReclaims; // The number of frames reclaimed by the page daemon
+	long tlbHits; // The number of translations that hit the TLB
+	long tlbMisses; // The number of translations that missed the TLB
+	int processes; // The number of processes that have not terminated
+};
+
+struct MyKernel *mykernelBoot(const char *backingStore);
+int mykernelSubmit(struct MyKernel *kernel, const char *command);
+int mykernelRun(struct MyKernel *kernel);
+int mykernelStats(struct MyKernel *kernel, struct MyKernelStats *stats);
+int mykernelShutdown(struct MyKernel *kernel);
+
+#endif
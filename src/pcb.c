@@ -6,19 +6,69 @@
 #include <stdlib.h>
 
 #include "pcb.h"
+#include "arena.h"
 
-// Creates a PCB
+KERNEL_STATE struct PCB *processList = NULL; // The head of the process list
+
+// Creates a PCB and adds it to the process list
+// The PCB is allocated from the session arena, and it is released to the arena when the process terminates
 struct PCB *makePCB(int PID, int pages_max) {
-	struct PCB *pcb = (struct PCB *) malloc(sizeof(struct PCB));
+	struct PCB *pcb = (struct PCB *) arenaAlloc(&sessionArena, sizeof(struct PCB));
 	pcb->PID = PID;
 	pcb->PC_page = 0;
 	pcb->PC_offset = 0;
 	pcb->pages_max = pages_max;
+	pcb->image = PID;
+	pcb->job = 0;
 
 	int i;
 	for (i = 0; i < RAM_SIZE / 4; i++) {
 		pcb->pageTable[i] = -1;
+		pcb->lastUse[i] = -1;
+	}
+
+	pcb->prevProcess = NULL;
+	pcb->nextProcess = processList;
+	if (processList != NULL) {
+		processList->prevProcess = pcb;
 	}
+	processList = pcb;
 
 	return pcb;
 }
+
+// Counts the number of frames mapped by PCB pcb
+int residentPages(struct PCB *pcb) {
+	int count = 0;
+	int i;
+	for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+		if (pcb->pageTable[i] != -1) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+// Terminates a PCB: releases the frames it maps, removes it from the process list and releases its memory to the session arena
+void freePCB(struct PCB *pcb) {
+	int i;
+	for (i = 0; i < RAM_SIZE / PAGE_SIZE; i++) {
+		int frame = pcb->pageTable[i];
+		if (frame != -1 && frameTable[frame].refs > 0) {
+			frameTable[frame].refs--; // The frame stays loaded, so another process running the same image can still map it
+		}
+	}
+
+	if (pcb->prevProcess != NULL) {
+		pcb->prevProcess->nextProcess = pcb->nextProcess;
+	} else {
+		processList = pcb->nextProcess;
+	}
+
+	if (pcb->nextProcess != NULL) {
+		pcb->nextProcess->prevProcess = pcb->prevProcess;
+	}
+
+	arenaFree(&sessionArena, pcb, sizeof(struct PCB));
+}
@@ -5,11 +5,7 @@
 #ifndef PCB_H
 #define PCB_H
 
-#include "ram.h" // For RAM_SIZE
-
-enum {
-    PAGE_SIZE = 4 // The number of instructions per page. This is equal to the number of instructions per frame, so page size = frame size.
-};
+#include "ram.h" // For RAM_SIZE and PAGE_SIZE
 
 // This is the structure for a process control block (PCB)
 // A PCB is a data structure that stores the information about a process that
@@ -24,8 +20,18 @@ struct PCB {
 	int PC_offset; // The index of the current line of the page being executed (also known as the page offset). This is an integer between 0 and PAGE_SIZE - 1.
 	int pageTable[RAM_SIZE / PAGE_SIZE]; // pageTable[i] is the index of the frame where the page with index i is stored in RAM. pageTable[i] == -1 means that page i is not stored in a frame
 	int pages_max; // The total number of pages that the file/script is made up of
+	int lastUse[RAM_SIZE / PAGE_SIZE]; // lastUse[i] is the scheduler tick at which page i was last dispatched, or -1 if it never was. This estimates the working set of the process.
+	int job; // The ID of the job the process belongs to
+	int wakeTick; // The scheduler tick at which the process wakes up, while it is asleep after a 'sleep' instruction
+	int image; // The script image in the backing store whose pages the process executes. Processes running identical scripts share an image and its frames.
+	struct PCB *prevProcess, *nextProcess; // The neighbours of the PCB in the process list
 };
 
+// The process list links every PCB that has not terminated, wherever it is queued
+extern KERNEL_STATE struct PCB *processList;
+
 struct PCB *makePCB(int PID, int pages_max);
+void freePCB(struct PCB *pcb);
+int residentPages(struct PCB *pcb);
 
 #endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file records the latencies measured by the probes in histograms and displays them
+// It is only compiled into the program when it is built with 'make PROBES=1'.
+#include "probe.h"
+
+#ifdef PROBES
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROBE_UNIT "cycles"
+#else
+#define PROBE_UNIT "ns"
+#endif
+
+#include "state.h"
+
+enum {
+	SUB_BUCKET_BITS = 3, // Every power of two is divided into 2^SUB_BUCKET_BITS buckets, so a percentile is within 12.5% of the exact value
+	SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+	BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS // The number of buckets needed for any 64-bit latency
+};
+
+// The latencies measured by one probe
+struct ProbeHistogram {
+	uint64_t count; // The number of latencies measured
+	uint64_t total; // The sum of the latencies
+	uint64_t max; // The largest latency
+	uint64_t buckets[BUCKET_COUNT]; // buckets[i] is the number of latencies that fell into bucket i
+};
+
+const char *probeNames[PROBE_COUNT] = { "parse", "interpreter", "run", "loadPage", "findVictim", "updatePageTable", "schedulerStep" };
+KERNEL_STATE struct ProbeHistogram probeHistograms[PROBE_COUNT]; // The histogram of every probe
+
+// Returns the current time of the probe clock: the time-stamp counter on x86, and a monotonic clock in nanoseconds otherwise
+uint64_t readProbeClock() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+// Returns the index of the bucket that holds latency
+int bucketOf(uint64_t latency) {
+	if (latency < SUB_BUCKETS) {
+		return (int) latency;
+	}
+
+	int msb = 63 - __builtin_clzll(latency);
+	int shift = msb - SUB_BUCKET_BITS;
+	return (shift + 1) * SUB_BUCKETS + (int) ((latency >> shift) & (SUB_BUCKETS - 1));
+}
+
+// Returns the smallest latency that falls into bucket
+uint64_t bucketLowerBound(int bucket) {
+	if (bucket < SUB_BUCKETS) {
+		return (uint64_t) bucket;
+	}
+
+	int shift = bucket / SUB_BUCKETS - 1;
+	return (uint64_t) (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+}
+
+// Records the latency of the function timed by scope, which is called when the function returns
+// The histograms belong to the kernel of the calling thread, and the probed functions only run on that thread
+void endProbe(struct ProbeScope *scope) {
+	uint64_t latency = readProbeClock() - scope->start;
+	struct ProbeHistogram *h = &probeHistograms[scope->id];
+
+	h->count++;
+	h->total += latency;
+	h->buckets[bucketOf(latency)]++;
+	if (latency > h->max) {
+		h->max = latency;
+	}
+}
+
+// Returns the latency below which percent percent of the latencies of histogram h fall
+uint64_t percentile(struct ProbeHistogram *h, int percent) {
+	uint64_t rank = (h->count * percent + 99) / 100; // The rank of the latency, starting from 1
+	uint64_t seen = 0;
+	int i;
+	for (i = 0; i < BUCKET_COUNT; i++) {
+		seen += h->buckets[i];
+		if (seen >= rank) {
+			return bucketLowerBound(i);
+		}
+	}
+
+	return h->max;
+}
+
+// Displays the count, mean, p50, p99 and max latency of every probe that was reached
+// The report is written to stderr so that it does not mix with the output of the shell.
+void printProbes() {
+	fprintf(stderr, "%-16s %10s %12s %12s %12s %12s (%s)\n", "Probe", "Count", "Mean", "p50", "p99", "Max", PROBE_UNIT);
+
+	int i;
+	for (i = 0; i < PROBE_COUNT; i++) {
+		struct ProbeHistogram *h = &probeHistograms[i];
+		if (h->count == 0) {
+			continue;
+		}
+
+		fprintf(stderr, "%-16s %10llu %12llu %12llu %12llu %12llu\n", probeNames[i], (unsigned long long) h->count,
+				(unsigned long long) (h->total / h->count), (unsigned long long) percentile(h, 50),
+				(unsigned long long) percentile(h, 99), (unsigned long long) h->max);
+	}
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef PROBE_H
+#define PROBE_H
+
+// Probes time the hot paths of the kernel when the program is built with 'make PROBES=1'
+// PROBE(id) at the beginning of a function times the function until it returns, whichever return
+// statement it uses, and adds the time to the latency histogram of probe id. The histograms are
+// displayed by PROBE_REPORT() when the kernel shuts down. In a normal build, the macros compile to nothing.
+#ifdef PROBES
+
+#include <stdint.h>
+
+// The functions timed by probes
+enum ProbeID {
+	PROBE_PARSE,
+	PROBE_INTERPRETER,
+	PROBE_RUN,
+	PROBE_LOAD_PAGE,
+	PROBE_FIND_VICTIM,
+	PROBE_UPDATE_PAGE_TABLE,
+	PROBE_SCHEDULER_STEP,
+	PROBE_COUNT // The number of probes
+};
+
+// A probe that is timing the function in which it is declared
+struct ProbeScope {
+	enum ProbeID id;
+	uint64_t start; // The time at which the function started
+};
+
+uint64_t readProbeClock();
+void endProbe(struct ProbeScope *scope);
+void printProbes();
+
+#define PROBE(id) struct ProbeScope probeScope __attribute__((cleanup(endProbe))) = { (id), readProbeClock() }
+#define PROBE_REPORT() printProbes()
+
+#else
+
+#define PROBE(id)
+#define PROBE_REPORT()
+
+#endif
+
+#endif
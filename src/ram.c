@@ -6,7 +6,41 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "ram.h"
+#include "tlb.h"
+
+KERNEL_STATE char **ram = NULL; // The RAM, allocated by allocateRam() when the kernel boots
+KERNEL_STATE struct Frame *frameTable = NULL; // Allocated by allocateRam() when the kernel boots
+
+// Stores a copy of line in the cell of ram with index cell, or empties the cell if line is NULL
+// The line that the cell held is released to the session arena, so a frame that is reused does not grow it.
+void setRamLine(int cell, const char *line) {
+	arenaFreeString(&sessionArena, ram[cell]);
+	ram[cell] = line != NULL ? arenaStrdup(&sessionArena, line) : NULL;
+}
+
+// Allocates the RAM and the frame table on the heap, rather than in the thread-local state of the kernel, and clears them
+// Returns 0, or -1 if they could not be allocated
+int allocateRam() {
+	ram = (char **) calloc(RAM_SIZE, sizeof(char *));
+	frameTable = (struct Frame *) calloc(FRAME_COUNT, sizeof(struct Frame));
+	if (ram == NULL || frameTable == NULL) {
+		freeRam();
+		return -1;
+	}
+
+	clearRam();
+	return 0;
+}
+
+// Frees the RAM and the frame table, once the lines of the RAM have been released
+void freeRam() {
+	free(ram);
+	free(frameTable);
+	ram = NULL;
+	frameTable = NULL;
+}
 
 // Clears the RAM
 void clearRam() {
@@ -14,6 +48,15 @@ void clearRam() {
 
 	// Traverse the ram array
 	for (k = 0; k < RAM_SIZE; k++) {
-		ram[k] = NULL;
+		setRamLine(k, NULL);
 	}
+
+	// Traverse the frame table
+	for (k = 0; k < FRAME_COUNT; k++) {
+		frameTable[k].image = FREE_FRAME;
+		frameTable[k].page = -1;
+		frameTable[k].refs = 0;
+	}
+
+	flushTLB(); // The TLB entries point to frames that were cleared
 }
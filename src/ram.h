@@ -5,13 +5,32 @@
 #ifndef RAM_H
 #define RAM_H
 
+#include "state.h" // For KERNEL_STATE
+
 enum {
-    RAM_SIZE = 40 // The number of characters that can be stored in ram
+    RAM_SIZE = 40, // The number of characters that can be stored in ram
+    PAGE_SIZE = 4, // The number of instructions per page. This is equal to the number of instructions per frame, so page size = frame size.
+    FRAME_COUNT = RAM_SIZE / PAGE_SIZE, // The number of frames in ram
+    FREE_FRAME = -1 // The image of a frame that does not hold a page
+};
+
+// This structure describes the page held by a frame in ram
+// A frame holds page [page] of the script image [image], and can be shared by every process running that image
+struct Frame {
+	int image; // The script image whose page is stored in the frame. FREE_FRAME means that the frame does not hold a page.
+	int page; // The index of the page stored in the frame
+	int refs; // The number of page table entries (across all processes) that point to the frame
 };
 
-// This the the RAM, an array of strings (each string is an instruction in a file/script)
-char *ram[RAM_SIZE]; 
+// This the the RAM, an array of RAM_SIZE strings (each string is an instruction in a file/script)
+extern KERNEL_STATE char **ram;
+
+// The frame table: frameTable[i] describes the frame with index i, for i < FRAME_COUNT
+extern KERNEL_STATE struct Frame *frameTable;
 
+int allocateRam();
+void freeRam();
+void setRamLine(int cell, const char *line);
 void clearRam();
 
 #endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements a reader thread for redirected input (for example, mykernel < file.txt)
+// The reader thread reads the input in large chunks, splits it into lines and words, and passes the lines
+// to the shell through a bounded queue, so that reading and parsing the input overlap with its execution.
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "reader.h"
+#include "cpu.h" // For INSTRUCTION_SIZE
+
+pthread_mutex_t readerLock = PTHREAD_MUTEX_INITIALIZER; // Protects the line queue
+pthread_cond_t lineQueued = PTHREAD_COND_INITIALIZER; // Signaled when a line is added to the queue
+pthread_cond_t lineTaken = PTHREAD_COND_INITIALIZER; // Signaled when a line is removed from the queue or the reader is stopping
+struct InputLine *lineQueue[READER_QUEUE_SIZE]; // The lines waiting for the shell, in a circular buffer
+int lineQueueHead = 0; // The index of the oldest line in lineQueue
+int lineQueueCount = 0; // The number of lines in lineQueue
+int readerFd = -1; // The file descriptor read by the reader thread
+int readerStopping = 0; // Set to 1 to make the reader thread exit
+
+// Creates an input line from the len characters of text, splitting it into words delimited by spaces
+// like parse() does: leading spaces and the final new line character are ignored
+struct InputLine *makeInputLine(const char *text, int len, int endOfInput) {
+	struct InputLine *line = (struct InputLine *) malloc(sizeof(struct InputLine));
+	line->text = (char *) malloc(len + 1);
+	memcpy(line->text, text, len);
+	line->text[len] = '\0';
+	if (len > 0 && line->text[len - 1] == '\n') {
+		line->text[len - 1] = '\0';
+	}
+
+	int maxWords = len / 2 + 1; // Words are separated by at least one space
+	if (maxWords > INSTRUCTION_SIZE - 1) {
+		maxWords = INSTRUCTION_SIZE - 1;
+	}
+	line->words = (char **) malloc((maxWords + 1) * sizeof(char *));
+
+	int i = 0;
+	char *state;
+	char *word = strtok_r(line->text, " ", &state);
+	while (word != NULL && i < maxWords) {
+		line->words[i++] = word;
+		word = strtok_r(NULL, " ", &state);
+	}
+	line->words[i] = NULL;
+
+	line->endOfInput = endOfInput;
+	return line;
+}
+
+// Frees an input line returned by nextInputLine()
+void freeInputLine(struct InputLine *line) {
+	free(line->words);
+	free(line->text);
+	free(line);
+}
+
+// Adds a line made of the len characters of text to the queue, waiting while the queue is full
+// Returns 0 if the line was added, and -1 if the reader is stopping
+int queueLine(const char *text, int len, int endOfInput) {
+	struct InputLine *line = makeInputLine(text, len, endOfInput); // Split the line before taking the lock
+
+	pthread_mutex_lock(&readerLock);
+	while (lineQueueCount == READER_QUEUE_SIZE && !readerStopping) {
+		pthread_cond_wait(&lineTaken, &readerLock);
+	}
+
+	if (readerStopping) {
+		pthread_mutex_unlock(&readerLock);
+		freeInputLine(line);
+		return -1;
+	}
+
+	lineQueue[(lineQueueHead + lineQueueCount) % READER_QUEUE_SIZE] = line;
+	lineQueueCount++;
+	pthread_cond_signal(&lineQueued);
+	pthread_mutex_unlock(&readerLock);
+	return 0;
+}
+
+// The function executed by the reader thread: reads the input until the end and queues its lines
+// Like fgets() in the shell, a line longer than INSTRUCTION_SIZE - 2 characters is split into several lines.
+void *readInput(void *unused) {
+	(void) unused;
+	char *chunk = (char *) malloc(READER_CHUNK_SIZE);
+	char pending[INSTRUCTION_SIZE]; // The beginning of a line that continues in the next chunk
+	int pendingLen = 0;
+	int stopped = 0;
+
+	while (!stopped) {
+		ssize_t n = read(readerFd, chunk, READER_CHUNK_SIZE);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) { // End of the input
+			break;
+		}
+
+		char *position = chunk;
+		char *end = chunk + n;
+		while (position < end && !stopped) {
+			char *newline = (char *) memchr(position, '\n', end - position);
+			int len = newline != NULL ? (int) (newline - position + 1) : (int) (end - position);
+			if (len > INSTRUCTION_SIZE - 2 - pendingLen) {
+				len = INSTRUCTION_SIZE - 2 - pendingLen;
+			}
+
+			memcpy(pending + pendingLen, position, len);
+			pendingLen += len;
+			position += len;
+
+			if (pending[pendingLen - 1] == '\n' || pendingLen == INSTRUCTION_SIZE - 2) { // The line is complete
+				stopped = queueLine(pending, pendingLen, 0) != 0;
+				pendingLen = 0;
+			}
+		}
+	}
+
+	if (!stopped) {
+		// The last line is the one that does not end with a new line character, which is empty if the input ends with one
+		queueLine(pending, pendingLen, 1);
+	}
+
+	free(chunk);
+	return NULL;
+}
+
+// Starts a reader thread that reads the lines of file descriptor fd
+void startInputReader(int fd) {
+	readerFd = fd;
+	readerStopping = 0;
+	lineQueueHead = 0;
+	lineQueueCount = 0;
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, readInput, NULL);
+	pthread_detach(thread); // The reader thread may be blocked reading a pipe when the shell exits
+}
+
+// Removes the next line from the queue, waiting for the reader thread if the queue is empty
+// The line must be freed with freeInputLine()
+struct InputLine *nextInputLine() {
+	pthread_mutex_lock(&readerLock);
+	while (lineQueueCount == 0) {
+		pthread_cond_wait(&lineQueued, &readerLock);
+	}
+
+	struct InputLine *line = lineQueue[lineQueueHead];
+	lineQueueHead = (lineQueueHead + 1) % READER_QUEUE_SIZE;
+	lineQueueCount--;
+	pthread_cond_signal(&lineTaken);
+	pthread_mutex_unlock(&readerLock);
+
+	return line;
+}
+
+// Tells the reader thread to stop and discards the lines that have not been executed
+void stopInputReader() {
+	pthread_mutex_lock(&readerLock);
+	readerStopping = 1;
+	while (lineQueueCount > 0) {
+		freeInputLine(lineQueue[lineQueueHead]);
+		lineQueueHead = (lineQueueHead + 1) % READER_QUEUE_SIZE;
+		lineQueueCount--;
+	}
+	pthread_cond_broadcast(&lineTaken);
+	pthread_mutex_unlock(&readerLock);
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef READER_H
+#define READER_H
+
+enum {
+	READER_CHUNK_SIZE = 65536, // The number of bytes the reader thread reads from the input at once
+	READER_QUEUE_SIZE = 256 // The number of lines that can wait in the queue between the reader thread and the shell
+};
+
+// A line of input that has already been split into words by the reader thread
+struct InputLine {
+	char *text; // The characters of the line, with a null character after every word
+	char **words; // The words of the line, followed by NULL
+	int endOfInput; // 1 if this is the last line of the input
+};
+
+void startInputReader(int fd);
+struct InputLine *nextInputLine();
+void freeInputLine(struct InputLine *line);
+void stopInputReader();
+
+#endif
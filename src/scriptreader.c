@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements the script reader, which streams the lines of the scripts executed by 'run' and scanned for calls
+// The kernel is told that a script is read sequentially, and before every read returns, the next block of the script
+// is requested, so the disk reads it while the lines that were read are executed.
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "scriptreader.h"
+
+KERNEL_STATE struct ScriptReadStats scriptStats = { 0 }; // The statistics of the scripts read by 'run'
+
+// Opens the script filename for reading
+// Returns 0, or -1 if the script could not be opened
+int openScriptReader(struct ScriptReader *r, const char *filename) {
+	r->fd = open(filename, O_RDONLY);
+	if (r->fd == -1) {
+		return -1;
+	}
+
+	r->capacity = SCRIPT_READ_SIZE;
+	r->buffer = (char *) malloc(r->capacity);
+	r->start = 0;
+	r->end = 0;
+	r->offset = 0;
+	r->endOfFile = 0;
+	posix_fadvise(r->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	return 0;
+}
+
+// Reads more of the script into the buffer of r, after the line that is being read
+// The line is moved to the beginning of the buffer, and the buffer is doubled if the line fills it.
+void fillScriptBuffer(struct ScriptReader *r) {
+	if (r->start > 0) {
+		memmove(r->buffer, r->buffer + r->start, r->end - r->start);
+		r->end -= r->start;
+		r->start = 0;
+	}
+
+	if (r->end + 1 >= r->capacity) {
+		r->capacity *= 2;
+		r->buffer = (char *) realloc(r->buffer, r->capacity);
+	}
+
+	ssize_t n;
+	do {
+		n = read(r->fd, r->buffer + r->end, r->capacity - r->end - 1); // One byte is kept for a null character
+	} while (n == -1 && errno == EINTR);
+
+	if (n <= 0) {
+		r->endOfFile = 1;
+		return;
+	}
+
+	r->end += n;
+	r->offset += n;
+	posix_fadvise(r->fd, r->offset, SCRIPT_READ_SIZE, POSIX_FADV_WILLNEED); // Read ahead the next block
+}
+
+// Returns the next line of the script read by r, without its new line character, or NULL at the end of the script
+// *newline is set to 1 if the line ended with a new line character, and to 0 if it is the last line of the script.
+// The line is stored in the buffer of r, so it is only valid until the next line is read.
+char *readScriptLine(struct ScriptReader *r, int *newline) {
+	char *found;
+	size_t scanned = r->start; // The bytes from start to scanned do not hold a new line character
+	while ((found = (char *) memchr(r->buffer + scanned, '\n', r->end - scanned)) == NULL && !r->endOfFile) {
+		scanned = r->end - r->start; // The line is moved to the beginning of the buffer
+		fillScriptBuffer(r);
+	}
+
+	char *line = r->buffer + r->start;
+	if (found == NULL && r->start == r->end) {
+		return NULL; // End of the script
+	}
+
+	size_t len;
+	if (found != NULL) {
+		len = found - line;
+		r->start += len + 1;
+		*newline = 1;
+	} else {
+		len = r->end - r->start;
+		r->start = r->end;
+		*newline = 0;
+	}
+	line[len] = '\0';
+	return line;
+}
+
+// Closes the script read by r and releases its buffer
+void closeScriptReader(struct ScriptReader *r) {
+	close(r->fd);
+	free(r->buffer);
+	r->buffer = NULL;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SCRIPTREADER_H
+#define SCRIPTREADER_H
+
+#include <stddef.h>
+
+#include "state.h" // For KERNEL_STATE
+
+enum {
+	SCRIPT_READ_SIZE = 64 * 1024 // The initial size of the buffer of a script reader, and the size of its reads
+};
+
+// A reader that streams the lines of a script file, whatever their length
+// The file is read with large reads into a buffer, and the lines are returned in place. The buffer only grows to
+// hold the longest line, so reading a script uses the same memory whatever its size.
+struct ScriptReader {
+	int fd; // The script file
+	char *buffer; // The bytes read from the file that have not been returned yet, from start to end
+	size_t capacity; // The size of buffer
+	size_t start; // The position in buffer of the next line
+	size_t end; // The position in buffer after the last byte read
+	long long offset; // The position in the file after the last byte read
+	int endOfFile; // 1 once every byte of the file has been read
+};
+
+// The statistics of the scripts read by the 'run' command
+struct ScriptReadStats {
+	long scripts; // The number of scripts read
+	long lines; // The number of lines read
+	long long bytes; // The number of bytes read
+	long longestLine; // The number of characters in the longest line
+	double seconds; // The time spent executing the outermost 'run' commands
+};
+
+extern KERNEL_STATE struct ScriptReadStats scriptStats;
+
+int openScriptReader(struct ScriptReader *r, const char *filename);
+char *readScriptLine(struct ScriptReader *r, int *newline);
+void closeScriptReader(struct ScriptReader *r);
+
+#endif
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements the server mode (mykernel --listen PATH), in which local clients connect to a UNIX domain socket
+// Every client gets its own shell session, with its own variables and jobs, but all of them share one kernel: its
+// scheduler, its frames and its image cache. A single thread waits for the clients with epoll, executes their
+// commands one at a time and executes the background jobs between them. The standard output is redirected to a memory
+// file while the kernel executes, and what is written there is moved to the output of the session that owns the
+// command or the process, which is sent to its client without blocking.
+#define _GNU_SOURCE // For accept4() and memfd_create()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+
+#include "server.h"
+#include "shell.h"
+#include "shellmemory.h"
+#include "jobs.h"
+#include "kernel.h"
+#include "interpreter.h"
+
+struct Session *sessionList = NULL; // The sessions of the connected clients
+int sessionCount = 0; // The number of connected clients
+int lastSessionID = 0; // Last session ID
+int epollFd = -1; // The epoll instance that watches the listening socket, the signals and the clients
+int consoleFd = -1; // A copy of the standard output of the program, which is restored after every command
+int outputFd = -1; // The memory file that receives the standard output while the kernel executes
+
+// Returns the session with ID id, or NULL if its client is gone
+struct Session *findSession(int id) {
+	struct Session *session;
+	for (session = sessionList; session != NULL; session = session->next) {
+		if (session->id == id) {
+			return session;
+		}
+	}
+
+	return NULL;
+}
+
+// Appends length characters of text to the output of a session
+void appendOutput(struct Session *session, const char *text, size_t length) {
+	if (session->outputLength + length > session->outputCapacity) {
+		size_t capacity = session->outputCapacity > 0 ? session->outputCapacity : SERVER_READ_SIZE;
+		while (capacity < session->outputLength + length) {
+			capacity *= 2;
+		}
+		session->output = (char *) realloc(session->output, capacity);
+		session->outputCapacity = capacity;
+	}
+
+	memcpy(session->output + session->outputLength, text, length);
+	session->outputLength += length;
+}
+
+// Moves what was written to the standard output since the last call to the output of the current owner
+// The output of a session whose client is gone is discarded.
+void collectOutput() {
+	fflush(stdout);
+	off_t length = lseek(outputFd, 0, SEEK_CUR);
+	struct Session *session = findSession(currentOwner);
+	if (length > 0 && session != NULL) {
+		char buffer[SERVER_READ_SIZE];
+		off_t offset = 0;
+		while (offset < length) {
+			ssize_t received = pread(outputFd, buffer, SERVER_READ_SIZE, offset);
+			if (received <= 0) {
+				break;
+			}
+			appendOutput(session, buffer, received);
+			offset += received;
+		}
+	}
+
+	if (length > 0) {
+		ftruncate(outputFd, 0);
+		lseek(outputFd, 0, SEEK_SET);
+	}
+}
+
+// Called by switchOwner() when the kernel starts executing for another session: the output written so far belongs
+// to the previous owner, and the variables of the session of owner are used from now on
+void changeSession(int owner) {
+	collectOutput();
+	struct Session *session = findSession(owner);
+	useShellMemory(session != NULL ? session->memory : NULL);
+}
+
+// Redirects the standard output to the memory file before the kernel executes
+void captureOutput() {
+	fflush(stdout);
+	dup2(outputFd, STDOUT_FILENO);
+}
+
+// Moves what the kernel wrote to the output of the current owner, and restores the standard output
+void releaseOutput() {
+	collectOutput();
+	dup2(consoleFd, STDOUT_FILENO);
+}
+
+// Watches the socket of a session for room to send its output if writing is 1, or for its commands otherwise
+// The commands of a client are not read while it has output left to receive, so a client that stops reading
+// cannot make the output of its commands pile up in the server.
+void watchSession(struct Session *session, int writing) {
+	if (session->writing != writing) {
+		struct epoll_event event = { .events = writing ? EPOLLOUT : EPOLLIN, .data.ptr = session };
+		epoll_ctl(epollFd, EPOLL_CTL_MOD, session->fd, &event);
+		session->writing = writing;
+	}
+}
+
+// Sends as much of the output of a session as its socket accepts without blocking
+// Returns 0, or -1 if the client is gone
+int flushSession(struct Session *session) {
+	while (session->outputSent < session->outputLength) {
+		ssize_t written = write(session->fd, session->output + session->outputSent, session->outputLength - session->outputSent);
+		if (written == -1 && errno == EINTR) {
+			continue;
+		} else if (written == -1 && errno == EAGAIN) {
+			break; // The rest is sent when the socket is writable
+		} else if (written <= 0) {
+			return -1;
+		}
+		session->outputSent += written;
+	}
+
+	if (session->outputSent == session->outputLength) {
+		session->outputLength = 0;
+		session->outputSent = 0;
+	}
+	watchSession(session, session->outputLength > 0);
+	return 0;
+}
+
+// Creates a session for a client that connected on socket fd, and watches it with epoll
+void openSession(int fd) {
+	struct Session *session = (struct Session *) malloc(sizeof(struct Session));
+	session->id = ++lastSessionID;
+	session->fd = fd;
+	session->length = 0;
+	session->memory = createShellMemory();
+	session->output = NULL;
+	session->outputLength = 0;
+	session->outputSent = 0;
+	session->outputCapacity = 0;
+	session->writing = 0;
+	session->prev = NULL;
+	session->next = sessionList;
+	if (sessionList != NULL) {
+		sessionList->prev = session;
+	}
+	sessionList = session;
+	sessionCount++;
+
+	struct epoll_event event = { .events = EPOLLIN, .data.ptr = session };
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+	const char *banner = "Shell version 1.0 loaded!\nEnter 'help' to display all available commands\n$ ";
+	appendOutput(session, banner, strlen(banner));
+}
+
+// Closes the session of a client, and terminates its jobs since their output has nowhere to go
+void closeSession(struct Session *session) {
+	switchOwner(session->id);
+	int job;
+	while ((job = firstJob()) != 0) {
+		killJob(job);
+		cancelJob(job);
+	}
+	switchOwner(0);
+	releaseIdleMemory();
+
+	close(session->fd); // This also removes the socket from epoll
+
+	if (session->prev != NULL) {
+		session->prev->next = session->next;
+	} else {
+		sessionList = session->next;
+	}
+	if (session->next != NULL) {
+		session->next->prev = session->prev;
+	}
+	sessionCount--;
+	freeShellMemory(session->memory);
+	free(session->output);
+	free(session);
+}
+
+// Sends the output of every session, and closes the sessions whose client is gone
+void flushSessions() {
+	struct Session *session = sessionList;
+	while (session != NULL) {
+		struct Session *next = session->next;
+		if (flushSession(session) != 0) {
+			closeSession(session);
+		}
+		session = next;
+	}
+}
+
+// Executes a line received from a session, with its variables and jobs
+// Returns 1 if the client quit the shell, and 0 otherwise
+int executeLine(struct Session *session, char *line) {
+	switchOwner(session->id);
+	captureOutput();
+
+	parse(line);
+	reportFinishedJobs();
+	int quit = !shellRunning; // The 'quit' command only ends the session of the client
+	shellRunning = 1;
+	if (!quit) {
+		printf("$ ");
+	}
+
+	releaseOutput();
+	return quit;
+}
+
+// Executes one quantum of the background jobs of the sessions, and reports the jobs that have finished to their
+// sessions
+// Returns 1 if a process was executed, and 0 if no process could run
+int runBackgroundQuantum() {
+	captureOutput();
+
+	int executed = executeBackgroundQuantum();
+	struct Session *session; // Their jobs may also have finished during the command of another session
+	for (session = sessionList; session != NULL; session = session->next) {
+		switchOwner(session->id);
+		reportFinishedJobs();
+	}
+
+	releaseOutput();
+	return executed;
+}
+
+// Reads the characters sent by the client of a session, and executes every complete line
+// A line longer than INSTRUCTION_SIZE - 2 characters is split, like the shell does with fgets()
+// Returns 1 if the session must be closed, and 0 otherwise
+int readSession(struct Session *session) {
+	char buffer[SERVER_READ_SIZE];
+	ssize_t received = read(session->fd, buffer, SERVER_READ_SIZE);
+	if (received <= 0) {
+		return received == 0 || (errno != EAGAIN && errno != EINTR);
+	}
+
+	ssize_t i;
+	for (i = 0; i < received; i++) {
+		session->line[session->length++] = buffer[i];
+		if (buffer[i] == '\n' || session->length == INSTRUCTION_SIZE - 2) {
+			session->line[session->length] = '\0';
+			session->length = 0;
+			if (executeLine(session, session->line)) {
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// Creates the listening socket at path
+// Returns the socket, or -1 if it could not be created
+int listenOn(const char *path) {
+	struct sockaddr_un address = { .sun_family = AF_UNIX };
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		return -1;
+	}
+	strcpy(address.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd == -1) {
+		return -1;
+	}
+
+	// Remove the socket of a previous server, but never a file that is not a socket
+	struct stat st;
+	if (lstat(path, &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			close(fd);
+			return -1;
+		}
+		unlink(path);
+	}
+
+	if (bind(fd, (struct sockaddr *) &address, sizeof(address)) == -1 || listen(fd, SERVER_BACKLOG) == -1) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+// Runs the server on the UNIX domain socket at path until the program receives SIGINT or SIGTERM
+// Returns 0, or 1 if the socket could not be created
+int serve(const char *path) {
+	int listenFd = listenOn(path);
+	if (listenFd == -1) {
+		printf("Error: Could not listen on '%s'\n", path);
+		return 1;
+	}
+
+	// SIGINT and SIGTERM are received through a signalfd, so the server can stop cleanly between two commands
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigprocmask(SIG_BLOCK, &signals, NULL);
+	int signalFd = signalfd(-1, &signals, SFD_CLOEXEC);
+	signal(SIGPIPE, SIG_IGN); // A client that disconnects while it receives output must not kill the server
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+	struct epoll_event signalEvent = { .events = EPOLLIN, .data.ptr = &signalFd };
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &signalEvent);
+
+	consoleFd = dup(STDOUT_FILENO);
+	outputFd = memfd_create("mykernel-output", MFD_CLOEXEC);
+	ownerChanged = changeSession;
+	printf("Listening on '%s'\n", path);
+	fflush(stdout);
+
+	int running = 1;
+	int busy = 0; // 1 while the background jobs have processes that can run, so that clients are only polled
+	struct epoll_event events[SERVER_EVENTS];
+	while (running) {
+		int count = epoll_wait(epollFd, events, SERVER_EVENTS, busy ? 0 : -1);
+		int i;
+		for (i = 0; i < count; i++) {
+			if (events[i].data.ptr == NULL) { // New clients are waiting
+				int fd;
+				while ((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+					openSession(fd);
+				}
+			} else if (events[i].data.ptr == &signalFd) {
+				running = 0;
+			} else {
+				struct Session *session = (struct Session *) events[i].data.ptr;
+				if (session->writing) {
+					if (flushSession(session) != 0) {
+						closeSession(session);
+					}
+				} else if (readSession(session)) {
+					flushSession(session); // Send "Bye!" if the client is still reading
+					closeSession(session);
+				}
+			}
+		}
+
+		if (running) {
+			busy = runBackgroundQuantum();
+			flushSessions();
+		}
+	}
+
+	printf("Stopping the server (%d client%s connected)\n", sessionCount, sessionCount == 1 ? "" : "s");
+	while (sessionList != NULL) {
+		closeSession(sessionList);
+	}
+
+	ownerChanged = NULL;
+	close(outputFd);
+	close(consoleFd);
+	close(epollFd);
+	close(signalFd);
+	close(listenFd);
+	unlink(path);
+	return 0;
+}
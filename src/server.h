@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+
+#include "cpu.h" // For INSTRUCTION_SIZE
+#include "shellmemory.h"
+
+enum {
+	SERVER_BACKLOG = 128, // The number of connections that can wait to be accepted
+	SERVER_EVENTS = 64, // The number of events handled per call to epoll_wait()
+	SERVER_READ_SIZE = 4096 // The number of bytes read from a client at once
+};
+
+// A shell session of a client connected to the server
+struct Session {
+	int id; // The session ID, which is the owner of the jobs started by the client
+	int fd; // The socket of the client
+	char line[INSTRUCTION_SIZE]; // The characters received after the last complete line
+	int length; // The number of characters in line
+	struct ShellMemory *memory; // The variables of the session
+	char *output; // The output of the commands and processes of the session that the client has not received yet
+	size_t outputLength; // The number of characters in output
+	size_t outputSent; // The number of characters of output already sent to the client
+	size_t outputCapacity; // The size of output
+	int writing; // 1 if the socket is watched for room to send output, instead of for commands
+	struct Session *prev, *next; // The neighbours of the session in the list of sessions
+};
+
+int serve(const char *path);
+
+#endif
@@ -6,11 +6,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <poll.h>
 
 #include "cpu.h"
 #include "interpreter.h"
+#include "jobs.h"
+#include "reader.h"
+#include "probe.h"
 
-int shellRunning = 1; // When this is equal to 0, the shell will stop running
+KERNEL_STATE int shellRunning = 1; // When this is equal to 0, the shell will stop running
 
 // Removes spaces at the beginning of a string, if any
 int removeLeadingSpaces(char *line, int len) {
@@ -31,9 +36,25 @@ int removeLeadingSpaces(char *line, int len) {
 	return len; // Return the length of the new line
 }
 
+// Passes the words of a line that has already been split to the interpreter to be interpreted and executed
+int interpretWords(char *lineWords[]) {
+	if (lineWords[0] == NULL) {
+		return -1; // Ignore an empty line
+	}
+
+	char* words[INSTRUCTION_SIZE] = { NULL }; // The interpreter expects NULL after the last word
+	int i;
+	for (i = 0; lineWords[i] != NULL; i++) {
+		words[i] = lineWords[i];
+	}
+
+	return interpreter(words) != 0 ? -1 : 0;
+}
+
 // Parses a line into an array of words delimited by spaces and passes them to the interpreter to
 // be interpreted and executed
 int parse(char* line) {
+	PROBE(PROBE_PARSE);
 	int len = strlen(line);
 
 	if (len == 0) {
@@ -60,9 +81,10 @@ int parse(char* line) {
 	
 	// Initialize words array
 	int i = 0;
-	words[i] = strtok(line, " ");
-	while (words[i] != NULL) {
-		words[++i] = strtok(NULL, " ");
+	char *state; // strtok_r() keeps its position here, so a line split by another thread does not interfere
+	words[i] = strtok_r(line, " ", &state);
+	while (words[i] != NULL && i < INSTRUCTION_SIZE - 2) { // A line of any length is split into at most INSTRUCTION_SIZE - 1 words
+		words[++i] = strtok_r(NULL, " ", &state);
 	}
 
 	int errorCode = interpreter(words);
@@ -74,32 +96,72 @@ int parse(char* line) {
 	return errorCode;
 }
 
+// Returns 1 if a line of input can be read from stdin without waiting, and 0 otherwise
+int inputReady() {
+	struct pollfd fd = { .fd = fileno(stdin), .events = POLLIN };
+	return poll(&fd, 1, 0) > 0;
+}
+
+// Executes the background jobs until the user enters a command, the jobs have finished, or they are all blocked
+// This is only done when stdin is a terminal, which delivers one line at a time. Redirected input is
+// executed without waiting, and the background jobs make progress during 'exec' and 'wait' commands.
+void runBackgroundJobs() {
+	if (!isatty(fileno(stdin))) {
+		return;
+	}
+
+	while (hasBackgroundJobs() && !inputReady()) {
+		if (!executeBackgroundQuantum()) { // The background processes wait for a channel that only the user can unblock
+			break;
+		}
+		reportFinishedJobs();
+		fflush(stdout);
+	}
+}
+
 // Implements the shell UI that promts the user for input
 int shellUI() {
 	char line[INSTRUCTION_SIZE]; // The string that stores a single instruction from the user
 	int len; // The length of line
 	char *prompt = "$"; // The shell prompt
+	int redirected = !isatty(fileno(stdin)); // When the input is redirected, it is read by a reader thread
 
 	printf("Shell version 1.0 loaded!\n");
 	printf("Enter 'help' to display all available commands\n");
 
+	if (redirected) {
+		startInputReader(fileno(stdin));
+	}
+
 	while(shellRunning) {
+		reportFinishedJobs();
 		printf("%s ", prompt);
 
-		fflush(stdout);
-		
-		strcpy(line, "\0"); // Clear the line
-		fgets(line, INSTRUCTION_SIZE - 1, stdin); // Read the user input, up to a maximum of INSTRUCTION_SIZE - 1 characters
-		len = strlen(line); // Compute the length of the user input
-		int endOfRedirection = len == 0 || line[len - 1] != '\n'; // The line does not end with a new line character. This means it was not entered directly by the user, so it is the last line of redirection.
-		
-		// Parse and interpret the line (this executes the line)
-		parse(line);
+		int endOfRedirection;
+		if (redirected) {
+			// Nobody is waiting for the prompt, so the output is not flushed after every line
+			struct InputLine *input = nextInputLine();
+			endOfRedirection = input->endOfInput;
+			interpretWords(input->words);
+			freeInputLine(input);
+		} else {
+			fflush(stdout);
+			runBackgroundJobs();
+
+			strcpy(line, "\0"); // Clear the line
+			fgets(line, INSTRUCTION_SIZE - 1, stdin); // Read the user input, up to a maximum of INSTRUCTION_SIZE - 1 characters
+			len = strlen(line); // Compute the length of the user input
+			endOfRedirection = len == 0 || line[len - 1] != '\n'; // The line does not end with a new line character. This means it was not entered directly by the user, so it is the last line of redirection.
+
+			// Parse and interpret the line (this executes the line)
+			parse(line);
+		}
 
 		// Try to reopen stdin if end of redirection
 		// Redirection is when the contents of a file is redirected to stdin (for example, if the '<' operator like this: mykernel < file.txt)
 		if (endOfRedirection) { 
 			printf("\nRedirection finished!\n");
+			redirected = 0;
 			
 			if (!freopen("/dev/tty", "r", stdin)) { // Try to reopen stdin to read from the command line after redirection (after ./mykernel < testfile.txt)
     			// If could not repoen stdin to read from terminal
@@ -108,6 +170,10 @@ int shellUI() {
 		}
 	}
 
+	if (redirected) { // The shell exited before the end of the input
+		stopInputReader();
+	}
+
 	printf("Exiting shell...\n");
 	return 0;
 }
@@ -5,10 +5,13 @@
 #ifndef SHELL_H
 #define SHELL_H
 
-int shellRunning;
+#include "state.h" // For KERNEL_STATE
+
+extern KERNEL_STATE int shellRunning;
 
 int shellUI();
 int parse(char* line);
+int interpretWords(char *lineWords[]);
 void exitShell();
 
 #endif
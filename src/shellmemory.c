@@ -4,8 +4,11 @@
  */
 // This file implements the shell memory where shell variables are stored
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 
+#include "state.h"
+
 enum {
 	SHELL_MEMORY_SIZE = 1000 // The number of variables that can be stored in the shell memory by the user with the set VAR STRING shell command.
 };
@@ -16,15 +19,54 @@ struct MEM {
 	char value[SHELL_MEMORY_SIZE]; // The value of the variable
 };
 
-// The shell memory (an array of struct MEM)
-struct MEM mem[SHELL_MEMORY_SIZE];
+// The shell memory of a shell (an array of struct MEM)
+struct ShellMemory {
+	struct MEM mem[SHELL_MEMORY_SIZE];
+	int positions[SHELL_MEMORY_SIZE]; // To keep track of which elements of the mem array are null (0 represents null)
+};
+
+KERNEL_STATE struct ShellMemory *consoleMemory = NULL; // The shell memory of the console, allocated by boot() to keep the thread-local state small
+KERNEL_STATE struct ShellMemory *sessionMemory = NULL; // The shell memory of the server session in use, or NULL for the console
+
+// Returns the shell memory in use
+struct ShellMemory *currentShellMemory() {
+	return sessionMemory != NULL ? sessionMemory : consoleMemory;
+}
+
+// Creates an empty shell memory for a server session
+struct ShellMemory *createShellMemory() {
+	return (struct ShellMemory *) calloc(1, sizeof(struct ShellMemory));
+}
+
+// Releases the shell memory of a server session, which must not be in use
+void freeShellMemory(struct ShellMemory *memory) {
+	free(memory);
+}
+
+// Creates the empty shell memory of the console when the kernel boots
+// Returns 0, or -1 if it could not be allocated
+int createConsoleMemory() {
+	consoleMemory = createShellMemory();
+	return consoleMemory != NULL ? 0 : -1;
+}
 
-int positions[SHELL_MEMORY_SIZE] = { 0 }; // To keep track of which elements of the mem array are null (0 represents null)
+// Releases the shell memory of the console when the kernel shuts down
+void freeConsoleMemory() {
+	freeShellMemory(consoleMemory);
+	consoleMemory = NULL;
+}
+
+// Makes memory (or the shell memory of the console if memory is NULL) the shell memory in use
+void useShellMemory(struct ShellMemory *memory) {
+	sessionMemory = memory;
+}
 
 // Sets the value of a variable with name var
 // If the variable already exists in shell memory, then the value is overwritten
 // Otherwise, a new variable is created
 void setVar(char *var, char *value) {
+	struct MEM *mem = currentShellMemory()->mem;
+	int *positions = currentShellMemory()->positions;
 	int i;
 
 	// Traverse the shell memory to find the position where the value should be set
@@ -38,7 +80,7 @@ void setVar(char *var, char *value) {
 		// Check if the variable at position i has the name var
 		if (strcmp(var, mem[i].var) == 0) {
 			// If so, then update its value
-			strcpy(mem[i].value, value);
+			snprintf(mem[i].value, SHELL_MEMORY_SIZE, "%s", value); // A longer value is truncated
 			return;
 		}
 	}
@@ -47,13 +89,14 @@ void setVar(char *var, char *value) {
 	if (i == SHELL_MEMORY_SIZE) return;
 	
 	// Since no variable was found with the name var, create a new variable
-	strcpy(mem[i].var, var);
-	strcpy(mem[i].value, value);
+	snprintf(mem[i].var, SHELL_MEMORY_SIZE, "%s", var);
+	snprintf(mem[i].value, SHELL_MEMORY_SIZE, "%s", value);
 	positions[i] = 1; // Indicates that position i in shell memory contains a variable
 }
 
 // Returns the value of the variable with name var
 char* ValueOfVar(char *var) {
+	struct MEM *mem = currentShellMemory()->mem;
 	int i;
 	for (i = 0; i < SHELL_MEMORY_SIZE; i++) {
 
@@ -65,8 +108,22 @@ char* ValueOfVar(char *var) {
 	return "\0"; // Error: variable not found
 }
 
+// Returns the name of the variable at position i in shell memory
+// Variables are stored contiguously from position 0, so NULL is returned once i is past the last variable
+char* NameOfVarAt(int i) {
+	struct MEM *mem = currentShellMemory()->mem;
+	int *positions = currentShellMemory()->positions;
+	if (i < 0 || i >= SHELL_MEMORY_SIZE || positions[i] == 0) {
+		return NULL;
+	}
+
+	return mem[i].var;
+}
+
 // Clears all variables in shell memory
 void clearShellMemory() { 
+	struct MEM *mem = currentShellMemory()->mem;
+	int *positions = currentShellMemory()->positions;
 	int i;
 	for (i = 0; i < SHELL_MEMORY_SIZE; i++) {
 		strcpy(mem[i].value, "\0");
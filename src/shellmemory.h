@@ -5,8 +5,16 @@
 #ifndef SHELLMEMORY_H
 #define SHELLMEMORY_H
 
+struct ShellMemory; // The variables of a shell, defined in shellmemory.c
+
+struct ShellMemory *createShellMemory();
+void freeShellMemory(struct ShellMemory *memory);
+int createConsoleMemory();
+void freeConsoleMemory();
+void useShellMemory(struct ShellMemory *memory);
 void setVar(char *var, char *value);
 char* ValueOfVar(char *var);
+char* NameOfVarAt(int i);
 void clearShellMemory();
 
 #endif
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements the simulation mode, which drives the scheduler and the pager with synthetic processes
+// A synthetic process has no instructions: it only has a number of instructions to execute and a page reference
+// pattern. The processes are launched, dispatched, paged and suspended by the same kernel functions as the
+// processes of real scripts, but time only advances through an event queue, so large workloads run quickly.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "simulator.h"
+#include "kernel.h"
+#include "memorymanager.h"
+#include "cpu.h"
+#include "tlb.h"
+#include "arena.h"
+
+KERNEL_STATE struct SimEvent simEvents[SIM_MAX_EVENTS]; // The event queue, a binary min-heap ordered by time
+KERNEL_STATE int simEventCount = 0; // The number of events in the event queue
+KERNEL_STATE long simSequence = 0; // The sequence number of the next event
+
+// Returns 1 if event a must be handled before event b
+int eventBefore(struct SimEvent *a, struct SimEvent *b) {
+	return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+}
+
+// Adds an event of type type at time time to the event queue
+void scheduleEvent(long time, int type, struct ReadyQueue *rq) {
+	struct SimEvent event = { .time = time, .sequence = simSequence++, .type = type, .rq = rq };
+
+	// Move the event up from the last leaf of the heap
+	int i = simEventCount++;
+	while (i > 0 && eventBefore(&event, &simEvents[(i - 1) / 2])) {
+		simEvents[i] = simEvents[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	simEvents[i] = event;
+}
+
+// Removes the earliest event from the event queue and returns it
+struct SimEvent nextEvent() {
+	struct SimEvent first = simEvents[0];
+	struct SimEvent last = simEvents[--simEventCount];
+
+	// Move the last event down from the root of the heap
+	int i = 0;
+	while (2 * i + 1 < simEventCount) {
+		int child = 2 * i + 1;
+		if (child + 1 < simEventCount && eventBefore(&simEvents[child + 1], &simEvents[child])) {
+			child++;
+		}
+		if (!eventBefore(&simEvents[child], &last)) {
+			break;
+		}
+		simEvents[i] = simEvents[child];
+		i = child;
+	}
+	simEvents[i] = last;
+
+	return first;
+}
+
+// Chooses the page that synthetic process p executes after page page
+int nextPage(struct Simulation *sim, struct SimProcess *p, int page) {
+	if (sim->pattern == SIM_SEQUENTIAL) {
+		return (page + 1) % sim->pages;
+	} else if (sim->pattern == SIM_RANDOM) {
+		return rand_r(&p->seed) % sim->pages;
+	}
+
+	int window = sim->pages < SIM_LOCAL_WINDOW ? sim->pages : SIM_LOCAL_WINDOW;
+	if (rand_r(&p->seed) % SIM_LOCAL_MOVE == 0) {
+		p->window = rand_r(&p->seed) % (sim->pages - window + 1);
+	}
+
+	return p->window + rand_r(&p->seed) % window;
+}
+
+// Schedules a CPU_FREE event now if the CPU is idle, so that a process that became ready is dispatched
+void wakeCPU(struct SimState *s) {
+	if (s->cpuIdle) {
+		s->cpuIdle = 0;
+		scheduleEvent(s->now, SIM_CPU_FREE, NULL);
+	}
+}
+
+// Launches the processes that have arrived, as long as fewer than SIM_MAX_ADMITTED processes have a PCB
+// Each process is launched like a script given to the 'run' command, with the synthetic image -1 - PID
+// Returns 0, or -2 if a victim frame could not be found
+int admitProcesses(struct Simulation *sim, struct SimState *s) {
+	while (s->admitted < s->arrived && s->admitted - s->finished < SIM_MAX_ADMITTED) {
+		struct LaunchRequest request = { .pages_max = sim->pages, .image = -1 - (lastPID + 1), .job = 0 };
+		if (commitScript(&request, 1) != 0) {
+			return -2;
+		}
+
+		s->admissionWait += s->now - s->models[s->admitted].arrival;
+		s->admitted++;
+		wakeCPU(s);
+	}
+
+	return 0;
+}
+
+// Ends the quantum of the process of node rq: the process terminates, waits for its page fault, or goes
+// back to the ready queue, as in schedulerStep()
+// Returns 0, or -2 if a victim frame could not be found for a process that was admitted as a result
+int endQuantum(struct Simulation *sim, struct SimState *s, struct ReadyQueue *rq) {
+	struct SimProcess *p = &s->models[rq->pcb->PID - s->firstPID];
+	int terminated = p->instructionsLeft == 0;
+
+	if (terminated) {
+		s->turnaround += s->now - p->arrival;
+		s->finished++;
+		terminateProcess(rq);
+	} else if (p->blocked) {
+		p->blocked = 0;
+		scheduleEvent(s->now + sim->latency, SIM_FAULT_DONE, rq);
+	} else {
+		addRQToReady(rq);
+	}
+
+	endDispatch();
+
+	return terminated ? admitProcesses(sim, s) : 0;
+}
+
+// Dispatches the process at the head of the ready queue and schedules the end of its quantum
+// The quantum is modelled on run(): at most cpu.quanta instructions are executed, a quantum never crosses the end
+// of a page, and the dispatch that finds the offset at the end of the page only moves to the next page.
+void startQuantum(struct Simulation *sim, struct SimState *s) {
+	long faults = vmstats.pageFaults;
+	struct ReadyQueue *rq = dispatch();
+	if (rq == NULL) {
+		s->cpuIdle = 1;
+		return;
+	}
+
+	struct PCB *pcb = rq->pcb;
+	struct SimProcess *p = &s->models[pcb->PID - s->firstPID];
+	long count = 0;
+
+	if (vmstats.pageFaults > faults && sim->latency > 0) {
+		p->blocked = 1; // The dispatch took a page fault on the current page
+	} else if (pcb->PC_offset == PAGE_SIZE) {
+		pcb->PC_page = nextPage(sim, p, pcb->PC_page);
+		pcb->PC_offset = 0;
+		if (pcb->pageTable[pcb->PC_page] == -1) {
+			pageFault(pcb, pcb->PC_page);
+			p->blocked = sim->latency > 0;
+		}
+	} else {
+		count = cpu.quanta;
+		if (count > PAGE_SIZE - pcb->PC_offset) {
+			count = PAGE_SIZE - pcb->PC_offset;
+		}
+		if (count > p->instructionsLeft) {
+			count = p->instructionsLeft;
+		}
+
+		pcb->PC_offset += count;
+		p->instructionsLeft -= count;
+		s->instructions += count;
+	}
+
+	scheduleEvent(s->now + count, SIM_CPU_FREE, rq);
+}
+
+// Displays the results of a simulation that took seconds of wall-clock time
+void printSimulation(struct Simulation *sim, struct SimState *s, double seconds) {
+	const char *patterns[] = { "sequential", "random", "local" };
+	long accesses = tlb.hits + tlb.misses;
+
+	printf("Simulated %ld processes of %ld instructions on %d pages (%s references)\n", sim->processes,
+			sim->instructions, sim->pages, patterns[sim->pattern]);
+	printf("Instructions: %ld, Simulated time: %ld, CPU utilization: %.1f%%\n", s->instructions, s->now,
+			s->now == 0 ? 0.0 : 100.0 * s->instructions / s->now);
+	printf("Page faults: %ld (%.1f per 1000 instructions), Suspensions: %ld, Resumptions: %ld\n", vmstats.pageFaults,
+			s->instructions == 0 ? 0.0 : 1000.0 * vmstats.pageFaults / s->instructions, vmstats.suspensions,
+			vmstats.resumptions);
+	printf("Reclaimed frames: %ld by page faults, %ld by the page daemon\n", vmstats.directReclaims, vmstats.daemonReclaims);
+	printf("TLB hit rate: %.1f%%, Mean turnaround: %.1f, Mean admission wait: %.1f\n",
+			accesses == 0 ? 0.0 : 100.0 * tlb.hits / accesses, (double) s->turnaround / sim->processes,
+			(double) s->admissionWait / sim->processes);
+	printf("Wall time: %.3f s (%.2f million simulated instructions per second)\n", seconds,
+			seconds == 0 ? 0.0 : s->instructions / seconds / 1e6);
+}
+
+// Runs a simulation: sim->processes synthetic processes arrive every sim->interval instructions, and each executes
+// sim->instructions instructions. The statistics of the kernel are saved before the simulation and restored after it,
+// so that the results only describe the synthetic processes. No other process can exist during the simulation.
+// Returns 0, -1 if there is not enough memory, or -2 if a victim frame could not be found
+int simulate(struct Simulation *sim) {
+	struct SimState s = { .firstPID = lastPID + 1, .cpuIdle = 1 };
+	s.models = (struct SimProcess *) calloc(sim->processes, sizeof(struct SimProcess));
+	if (s.models == NULL) {
+		return -1;
+	}
+
+	int savedPID = lastPID;
+	struct VMStats savedStats = vmstats;
+	long savedHits = tlb.hits, savedMisses = tlb.misses, savedFlushes = tlb.flushes;
+	struct FaultWindow savedWindow = saveFaultWindow();
+	vmstats = (struct VMStats) { 0 };
+	tlb.hits = 0;
+	tlb.misses = 0;
+	tlb.flushes = 0;
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	simEventCount = 0;
+	scheduleEvent(0, SIM_ARRIVAL, NULL);
+
+	int error = 0;
+	while (simEventCount > 0 && error == 0) {
+		struct SimEvent event = nextEvent();
+		s.now = event.time;
+
+		if (event.type == SIM_ARRIVAL) {
+			struct SimProcess *p = &s.models[s.arrived];
+			p->instructionsLeft = sim->instructions;
+			p->arrival = s.now;
+			p->seed = s.firstPID + s.arrived;
+			s.arrived++;
+			if (s.arrived < sim->processes) { // The arrivals are chained, so only one is ever in the event queue
+				scheduleEvent(s.now + sim->interval, SIM_ARRIVAL, NULL);
+			}
+			error = admitProcesses(sim, &s);
+		} else if (event.type == SIM_FAULT_DONE) {
+			addRQToReady(event.rq);
+			wakeCPU(&s);
+		} else {
+			if (event.rq != NULL) {
+				error = endQuantum(sim, &s, event.rq);
+			}
+			if (error == 0) {
+				startQuantum(sim, &s);
+			}
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (error == 0) {
+		printSimulation(sim, &s, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+	}
+
+	// Terminate the processes left by an error, and release their frames and their memory
+	while (simEventCount > 0) {
+		struct SimEvent event = nextEvent();
+		if (event.rq != NULL) {
+			terminateProcess(event.rq);
+		}
+	}
+	clearReadyQueue();
+	clearRam();
+	resetArena(&sessionArena);
+
+	lastPID = savedPID;
+	vmstats = savedStats;
+	restoreFaultWindow(&savedWindow);
+	tlb.hits = savedHits;
+	tlb.misses = savedMisses;
+	tlb.flushes = savedFlushes;
+	free(s.models);
+
+	return error;
+}
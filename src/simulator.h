@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "cpu.h" // For struct ReadyQueue
+
+enum {
+	SIM_SEQUENTIAL = 0, // A synthetic process executes its pages in order, and starts again from its first page
+	SIM_RANDOM = 1, // A synthetic process jumps to a random page after each page
+	SIM_LOCAL = 2, // A synthetic process mostly executes the pages of a small window, which sometimes moves
+	SIM_LOCAL_WINDOW = 3, // The number of pages in the window of the SIM_LOCAL pattern
+	SIM_LOCAL_MOVE = 8, // The window of the SIM_LOCAL pattern moves after one page in SIM_LOCAL_MOVE, on average
+	SIM_MAX_ADMITTED = 32, // The maximum number of synthetic processes that have a PCB at the same time
+	SIM_MAX_EVENTS = SIM_MAX_ADMITTED + 2 // Every admitted process waits for at most one event, plus one arrival and the CPU
+};
+
+enum {
+	SIM_ARRIVAL = 0, // The next synthetic process arrives
+	SIM_CPU_FREE = 1, // The CPU has finished executing a quantum and can dispatch the next process
+	SIM_FAULT_DONE = 2 // A page fault has been served, so the process that took it is ready again
+};
+
+// The parameters of a simulation
+struct Simulation {
+	long processes; // The number of synthetic processes
+	long instructions; // The number of instructions each process executes
+	int pages; // The number of pages of each process
+	int pattern; // The page reference pattern: SIM_SEQUENTIAL, SIM_RANDOM or SIM_LOCAL
+	long interval; // The time between the arrivals of two processes
+	long latency; // The time a process waits for a page fault to be served
+};
+
+// A synthetic process: it has no instructions, only a number of instructions left and a page reference pattern
+struct SimProcess {
+	long instructionsLeft;
+	long arrival; // The time at which the process arrived
+	unsigned int seed; // The state of the random number generator of the process
+	int window; // The first page of the window of the SIM_LOCAL pattern
+	int blocked; // 1 if the last quantum of the process ended with a page fault that it must wait for
+};
+
+// An event of the simulation, which happens at a given time
+struct SimEvent {
+	long time;
+	long sequence; // Orders the events that happen at the same time by the order in which they were scheduled
+	int type; // ARRIVAL, CPU_FREE or FAULT_DONE
+	struct ReadyQueue *rq; // The process that was executing (CPU_FREE) or whose page fault was served (FAULT_DONE)
+};
+
+// The state and the statistics of a running simulation
+struct SimState {
+	struct SimProcess *models; // models[i] is the synthetic process with PID firstPID + i
+	int firstPID;
+	long now; // The simulated time, in instructions
+	long arrived; // The number of processes that have arrived
+	long admitted; // The number of processes that have been given a PCB
+	long finished; // The number of processes that have terminated
+	int cpuIdle; // 1 if no CPU_FREE event is scheduled because no process could run
+	long instructions; // The number of instructions executed
+	long turnaround; // The sum of the times between the arrival and the termination of the processes
+	long admissionWait; // The sum of the times between the arrival and the admission of the processes
+};
+
+int simulate(struct Simulation *sim);
+
+#endif
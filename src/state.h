@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef STATE_H
+#define STATE_H
+
+// The variables that hold the state of a kernel (its RAM, its queues, its shell memory, its statistics...) are
+// declared with KERNEL_STATE. Each thread has its own copy of them, so every thread of a program can boot and
+// run its own kernel (see mykernel.h). The worker threads of the thread pool never read them.
+// Every thread of the program pays for the size of these variables, even if it never boots a kernel, so the large
+// tables (the RAM, the image cache, the shell memory) are allocated by boot() and only their pointers are declared here.
+#define KERNEL_STATE __thread
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements a pool of worker threads that execute tasks in the background
+// The worker threads are started the first time a task is submitted. They are shared by every kernel of the program,
+// and they only read the tasks they are given, never the state of a kernel.
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "threadpool.h"
+
+pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER; // Protects the task queue and the done flags of the tasks
+pthread_cond_t taskSubmitted = PTHREAD_COND_INITIALIZER; // Signaled when a task is added to the queue or the pool is stopping
+pthread_cond_t taskDone = PTHREAD_COND_INITIALIZER; // Signaled when a worker thread finishes a task
+pthread_t workers[POOL_THREADS]; // The worker threads
+int poolStarted = 0; // 1 once the worker threads have been created
+int poolStopping = 0; // Set to 1 to make the worker threads exit
+int poolUsers = 0; // The number of kernels that use the pool
+struct Task *taskHead = NULL, *taskTail = NULL; // The queue of tasks waiting for a worker thread
+
+// The function executed by every worker thread: takes tasks from the queue and executes them
+void *worker(void *unused) {
+	(void) unused;
+	pthread_mutex_lock(&poolLock);
+
+	while (1) {
+		while (taskHead == NULL && !poolStopping) {
+			pthread_cond_wait(&taskSubmitted, &poolLock);
+		}
+
+		if (taskHead == NULL) { // The pool is stopping and there is no more work
+			break;
+		}
+
+		struct Task *task = taskHead;
+		taskHead = task->next;
+		if (taskHead == NULL) {
+			taskTail = NULL;
+		}
+
+		pthread_mutex_unlock(&poolLock);
+		task->function(task->argument);
+		pthread_mutex_lock(&poolLock);
+
+		task->done = 1;
+		pthread_cond_broadcast(&taskDone);
+	}
+
+	pthread_mutex_unlock(&poolLock);
+	return NULL;
+}
+
+// Creates the worker threads
+// The caller must hold the pool lock.
+void startWorkers() {
+	poolStarted = 1;
+	poolStopping = 0;
+	int i;
+	for (i = 0; i < POOL_THREADS; i++) {
+		pthread_create(&workers[i], NULL, worker, NULL);
+	}
+}
+
+// Queues task, which will call function(argument) on a worker thread
+void submitTask(struct Task *task, void (*function)(void *), void *argument) {
+	task->function = function;
+	task->argument = argument;
+	task->done = 0;
+	task->next = NULL;
+
+	pthread_mutex_lock(&poolLock);
+
+	if (!poolStarted) {
+		startWorkers();
+	}
+
+	if (taskHead == NULL) {
+		taskHead = task;
+	} else {
+		taskTail->next = task;
+	}
+	taskTail = task;
+
+	pthread_cond_signal(&taskSubmitted);
+	pthread_mutex_unlock(&poolLock);
+}
+
+// Waits until task has been executed
+void waitTask(struct Task *task) {
+	pthread_mutex_lock(&poolLock);
+	while (!task->done) {
+		pthread_cond_wait(&taskDone, &poolLock);
+	}
+	pthread_mutex_unlock(&poolLock);
+}
+
+// Records that a kernel uses the pool
+void retainThreadPool() {
+	pthread_mutex_lock(&poolLock);
+	poolUsers++;
+	pthread_mutex_unlock(&poolLock);
+}
+
+// Records that a kernel no longer uses the pool
+// Once no kernel uses it, the queued tasks are finished and the worker threads are stopped
+void releaseThreadPool() {
+	pthread_mutex_lock(&poolLock);
+	if (poolUsers > 0) {
+		poolUsers--;
+	}
+	if (!poolStarted || poolStopping || poolUsers > 0) { // A pool that is stopping is handled by the thread stopping it
+		pthread_mutex_unlock(&poolLock);
+		return;
+	}
+
+	poolStopping = 1;
+	pthread_cond_broadcast(&taskSubmitted);
+	pthread_mutex_unlock(&poolLock);
+
+	int i;
+	for (i = 0; i < POOL_THREADS; i++) {
+		pthread_join(workers[i], NULL);
+	}
+
+	pthread_mutex_lock(&poolLock);
+	poolStarted = 0;
+	poolStopping = 0;
+	if (taskHead != NULL) { // A kernel booted and submitted a task while the worker threads were exiting
+		startWorkers();
+	}
+	pthread_mutex_unlock(&poolLock);
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+enum {
+	POOL_THREADS = 4 // The number of worker threads in the thread pool
+};
+
+// A task executed by a worker thread of the thread pool: the thread calls function(argument)
+// The task is owned by the caller, which must not reuse it before waitTask() has returned
+struct Task {
+	void (*function)(void *);
+	void *argument;
+	int done; // Set to 1 by the worker thread once function has returned
+	struct Task *next; // The next task in the queue of the thread pool
+};
+
+void submitTask(struct Task *task, void (*function)(void *), void *argument);
+void waitTask(struct Task *task);
+void retainThreadPool();
+void releaseThreadPool();
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements the timer wheel that holds the processes put to sleep by the 'sleep' instruction
+// A sleeping process is not in the ready queue, so the scheduler only spends time on the processes that can run.
+// Putting a process to sleep and waking it up take constant time, and so does skipping the ticks in which no
+// process wakes up while every process is asleep.
+#include <stddef.h>
+
+#include "timer.h"
+#include "kernel.h"
+
+KERNEL_STATE struct TimerWheel timerWheel; // The sleeping processes
+
+// Appends ready queue node rq to slot slot of level level
+void addToSlot(int level, int slot, struct ReadyQueue *rq) {
+	struct TimerSlot *s = &timerWheel.slots[level][slot];
+	rq->next = NULL;
+	if (s->head == NULL) {
+		s->head = rq;
+	} else {
+		s->tail->next = rq;
+	}
+	s->tail = rq;
+	timerWheel.occupied[level] |= (uint64_t) 1 << slot;
+}
+
+// Stores the process of ready queue node rq in the timer wheel, or adds it to the ready queue if its wake-up
+// tick has been reached
+void placeTimer(struct ReadyQueue *rq) {
+	if (rq->pcb->wakeTick <= timerWheel.now) {
+		timerWheel.count--;
+		addRQToReady(rq);
+		return;
+	}
+
+	unsigned int difference = (unsigned int) rq->pcb->wakeTick ^ (unsigned int) timerWheel.now;
+	int level = (31 - __builtin_clz(difference)) / TIMER_BITS; // The highest group of bits that differs
+	int slot = (rq->pcb->wakeTick >> (TIMER_BITS * level)) & (TIMER_SLOTS - 1);
+	addToSlot(level, slot, rq);
+}
+
+// Puts the process of ready queue node rq to sleep until tick wakeTick
+void addTimer(struct ReadyQueue *rq, int wakeTick) {
+	rq->pcb->wakeTick = wakeTick;
+	timerWheel.count++;
+	placeTimer(rq);
+}
+
+// Removes the processes of slot slot of level level and places them again, which moves them to lower levels
+// or wakes them up
+void cascadeSlot(int level, int slot) {
+	struct ReadyQueue *rq = timerWheel.slots[level][slot].head;
+	timerWheel.slots[level][slot].head = NULL;
+	timerWheel.slots[level][slot].tail = NULL;
+	timerWheel.occupied[level] &= ~((uint64_t) 1 << slot);
+
+	while (rq != NULL) {
+		struct ReadyQueue *next = rq->next;
+		placeTimer(rq);
+		rq = next;
+	}
+}
+
+// Moves the timer wheel to tick now + 1: the slots whose range starts at that tick are cascaded, from the highest
+// level down, so that the processes that wake up at that tick reach the ready queue
+void tick() {
+	timerWheel.now++;
+
+	int level;
+	for (level = TIMER_LEVELS - 1; level >= 0; level--) {
+		long range = (long) 1 << (TIMER_BITS * level); // The number of ticks covered by a slot of the level
+		if (timerWheel.now % range == 0) {
+			cascadeSlot(level, (int) ((timerWheel.now / range) & (TIMER_SLOTS - 1)));
+		}
+	}
+}
+
+// Returns the first tick after the current tick at which a slot that holds processes is reached, or -1 if no
+// process is asleep
+// The processes of a level are always in the slots after its current slot, and every slot of a level is reached
+// before the next slot of the level above it, so the first such slot of the lowest level is the next one.
+long nextOccupiedTick() {
+	int level;
+	for (level = 0; level < TIMER_LEVELS; level++) {
+		int shift = TIMER_BITS * level;
+		int current = (timerWheel.now >> shift) & (TIMER_SLOTS - 1);
+		uint64_t later = current == TIMER_SLOTS - 1 ? 0 : timerWheel.occupied[level] & (~(uint64_t) 0 << (current + 1));
+		if (later != 0) {
+			long base = ((long) timerWheel.now >> (shift + TIMER_BITS)) << (shift + TIMER_BITS);
+			return base + ((long) __builtin_ctzll(later) << shift);
+		}
+	}
+
+	return -1;
+}
+
+// Moves the timer wheel forward to tick now, waking up the processes whose wake-up tick has been reached
+// The ticks at which no slot that holds processes is reached are skipped.
+void advanceTimers(int now) {
+	while (timerWheel.now < now) {
+		long next = nextOccupiedTick();
+		if (next == -1 || next > now) {
+			timerWheel.now = now;
+			return;
+		}
+
+		timerWheel.now = (int) next - 1;
+		tick();
+	}
+}
+
+// Moves the timer wheel forward until a sleeping process wakes up, while no other process can run
+// Returns the tick at which it woke up, or the current tick if no process is asleep
+int wakeNextSleeper() {
+	int woken = timerWheel.count;
+	while (timerWheel.count == woken && woken > 0) {
+		long next = nextOccupiedTick();
+		if (next == -1) {
+			break;
+		}
+
+		timerWheel.now = (int) next - 1;
+		tick();
+	}
+
+	return timerWheel.now;
+}
+
+// Terminates the sleeping processes of the job with ID job (or of every job of the current owner if job is ALL_JOBS)
+// Returns the number of processes terminated
+int killSleeping(int job) {
+	int count = 0;
+	int level, slot;
+	for (level = 0; level < TIMER_LEVELS; level++) {
+		for (slot = 0; slot < TIMER_SLOTS; slot++) {
+			struct TimerSlot *s = &timerWheel.slots[level][slot];
+			if (s->head != NULL) {
+				count += killFromQueue(&s->head, &s->tail, job);
+				if (s->head == NULL) {
+					timerWheel.occupied[level] &= ~((uint64_t) 1 << slot);
+				}
+			}
+		}
+	}
+
+	timerWheel.count -= count;
+	return count;
+}
+
+// Wakes up every sleeping process, in the order of the slots
+void wakeAllSleepers() {
+	int level, slot;
+	for (level = 0; level < TIMER_LEVELS; level++) {
+		for (slot = 0; slot < TIMER_SLOTS; slot++) {
+			struct ReadyQueue *rq = timerWheel.slots[level][slot].head;
+			while (rq != NULL) {
+				struct ReadyQueue *next = rq->next;
+				addRQToReady(rq);
+				rq = next;
+			}
+			timerWheel.slots[level][slot].head = NULL;
+			timerWheel.slots[level][slot].tail = NULL;
+		}
+		timerWheel.occupied[level] = 0;
+	}
+
+	timerWheel.count = 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+#include "cpu.h" // For struct ReadyQueue
+
+enum {
+	TIMER_BITS = 6, // Every level of the timer wheel has 2^TIMER_BITS slots
+	TIMER_SLOTS = 1 << TIMER_BITS,
+	TIMER_LEVELS = 6, // Enough levels to tell apart any two ticks that fit in an int
+	SLEEP_MAX = 1000000 // The maximum number of ticks a process can sleep for
+};
+
+// A slot of the timer wheel: the sleeping processes whose wake-up ticks fall into the same range
+struct TimerSlot {
+	struct ReadyQueue *head, *tail;
+};
+
+// This structure implements a hierarchical timer wheel, which wakes up the processes put to sleep by 'sleep'
+// Level L has TIMER_SLOTS slots of 2^(TIMER_BITS * L) ticks each. A process is stored in the level of the highest
+// group of TIMER_BITS bits in which its wake-up tick differs from the current tick, so it is always in a slot after
+// the current slot of its level. When the current tick enters the range of a slot, its processes are moved down to
+// the lower levels, and the processes of the current slot of level 0 are woken up.
+struct TimerWheel {
+	struct TimerSlot slots[TIMER_LEVELS][TIMER_SLOTS];
+	uint64_t occupied[TIMER_LEVELS]; // Bit i of occupied[L] is set if slot i of level L holds a process
+	int now; // The tick up to which the sleeping processes have been woken up
+	int count; // The number of sleeping processes
+};
+
+extern KERNEL_STATE struct TimerWheel timerWheel;
+
+void addTimer(struct ReadyQueue *rq, int wakeTick);
+void advanceTimers(int now);
+int wakeNextSleeper();
+int killSleeping(int job);
+void wakeAllSleepers();
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file simulates a translation lookaside buffer (TLB) in front of the page tables of the PCBs
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tlb.h"
+
+// Initialize the TLB: 8 entries, 2-way set associative, LRU replacement, flushed on context switch
+KERNEL_STATE struct TLB tlb = {.size = 8, .ways = 2, .policy = TLB_LRU, .mode = TLB_FLUSH, .lastPID = -1};
+
+// Changes the geometry and policies of the TLB, which flushes it and resets its statistics
+// Returns 0 if the configuration is valid, and -1 otherwise
+int configureTLB(int size, int ways, int policy, int mode) {
+	if (size < 1 || size > TLB_MAX_ENTRIES || ways < 1 || ways > size || size % ways != 0) {
+		return -1;
+	}
+
+	tlb.size = size;
+	tlb.ways = ways;
+	tlb.policy = policy;
+	tlb.mode = mode;
+	tlb.lastPID = -1;
+	tlb.clock = 0;
+	flushTLB();
+	tlb.hits = 0;
+	tlb.misses = 0;
+	tlb.flushes = 0;
+
+	return 0;
+}
+
+// Returns the index of the first entry of the set where page can be cached
+int firstEntryOfSet(int page) {
+	int sets = tlb.size / tlb.ways;
+	return (page % sets) * tlb.ways;
+}
+
+// Looks up the translation of page for process PID
+// Returns the frame number on a hit, and -1 on a miss
+int lookupTLB(int PID, int page) {
+	int first = firstEntryOfSet(page);
+	tlb.clock++;
+
+	int i;
+	for (i = first; i < first + tlb.ways; i++) {
+		struct TLBEntry *e = &tlb.entries[i];
+		if (e->valid && e->PID == PID && e->page == page) {
+			if (tlb.policy == TLB_LRU) {
+				e->stamp = tlb.clock;
+			}
+			tlb.hits++;
+			return e->frame;
+		}
+	}
+
+	tlb.misses++;
+	return -1;
+}
+
+// Caches the translation of page to frame for process PID, replacing an entry of its set if the set is full
+void insertTLB(int PID, int page, int frame) {
+	int first = firstEntryOfSet(page);
+	int victim = -1;
+
+	int i;
+	for (i = first; i < first + tlb.ways; i++) {
+		if (!tlb.entries[i].valid) {
+			victim = i;
+			break;
+		}
+	}
+
+	if (victim == -1) { // The set is full
+		if (tlb.policy == TLB_RANDOM) {
+			victim = first + rand() % tlb.ways;
+		} else { // LRU and FIFO both evict the entry with the oldest stamp
+			victim = first;
+			for (i = first + 1; i < first + tlb.ways; i++) {
+				if (tlb.entries[i].stamp < tlb.entries[victim].stamp) {
+					victim = i;
+				}
+			}
+		}
+	}
+
+	struct TLBEntry *e = &tlb.entries[victim];
+	e->valid = 1;
+	e->PID = PID;
+	e->page = page;
+	e->frame = frame;
+	e->stamp = tlb.clock;
+}
+
+// Invalidates every entry that translates to frame, which is necessary when the frame is given to another page
+void invalidateTLBFrame(int frame) {
+	int i;
+	for (i = 0; i < tlb.size; i++) {
+		if (tlb.entries[i].frame == frame) {
+			tlb.entries[i].valid = 0;
+		}
+	}
+}
+
+// Invalidates every entry of the TLB
+void flushTLB() {
+	int i;
+	for (i = 0; i < TLB_MAX_ENTRIES; i++) {
+		tlb.entries[i].valid = 0;
+	}
+}
+
+// Tells the TLB which process is about to use it
+// In TLB_FLUSH mode, the TLB is flushed if the process is different from the last one
+void switchTLBContext(int PID) {
+	if (PID != tlb.lastPID && tlb.mode == TLB_FLUSH) {
+		flushTLB();
+		tlb.flushes++;
+	}
+
+	tlb.lastPID = PID;
+}
+
+// Displays the configuration and statistics of the TLB
+void printTLB() {
+	const char *policies[] = { "LRU", "FIFO", "random" };
+	long accesses = tlb.hits + tlb.misses;
+
+	printf("TLB: %d entries, %d-way, %s replacement, %s on context switch\n", tlb.size, tlb.ways,
+			policies[tlb.policy], tlb.mode == TLB_FLUSH ? "flushed" : "tagged");
+	printf("Hits: %ld, Misses: %ld, Hit rate: %.1f%%, Flushes: %ld\n", tlb.hits, tlb.misses,
+			accesses == 0 ? 0.0 : 100.0 * tlb.hits / accesses, tlb.flushes);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef TLB_H
+#define TLB_H
+
+#include "state.h" // For KERNEL_STATE
+
+enum {
+	TLB_MAX_ENTRIES = 64, // The maximum number of entries in the TLB
+	TLB_LRU = 0, // Replace the least recently used entry of a set
+	TLB_FIFO = 1, // Replace the oldest entry of a set
+	TLB_RANDOM = 2, // Replace a random entry of a set
+	TLB_FLUSH = 0, // Flush the TLB on every context switch
+	TLB_TAGGED = 1 // Tag every entry with the PID of its process, so entries survive context switches
+};
+
+// An entry of the TLB: caches the translation of page [page] of process [PID] to frame [frame]
+struct TLBEntry {
+	int valid; // 1 if the entry holds a translation
+	int PID; // The process the translation belongs to
+	int page; // The page number
+	int frame; // The frame number
+	unsigned long stamp; // The time of the last use (LRU) or of the insertion (FIFO)
+};
+
+// This structure simulates a translation lookaside buffer (TLB), a cache of page table entries
+// The TLB is divided into size / ways sets of ways entries, and page i can only be cached in set i % (size / ways)
+struct TLB {
+	struct TLBEntry entries[TLB_MAX_ENTRIES];
+	int size; // The number of entries in use
+	int ways; // The associativity
+	int policy; // The replacement policy: TLB_LRU, TLB_FIFO or TLB_RANDOM
+	int mode; // What happens on a context switch: TLB_FLUSH or TLB_TAGGED
+	int lastPID; // The PID of the last process that used the TLB
+	unsigned long clock; // Incremented on every access, used for the stamps
+	long hits, misses, flushes; // Statistics
+};
+
+extern KERNEL_STATE struct TLB tlb;
+
+int configureTLB(int size, int ways, int policy, int mode);
+int lookupTLB(int PID, int page);
+void insertTLB(int PID, int page, int frame);
+void invalidateTLBFrame(int frame);
+void flushTLB();
+void switchTLBContext(int PID);
+void printTLB();
+
+#endif
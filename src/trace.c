@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file records the page references and page faults of the kernel into a binary trace file
+// The trace can be replayed offline with the tracereplay program, under other replacement policies and frame counts.
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+#include "ram.h"
+
+const char TRACE_MAGIC[8] = "MYKTRCE"; // Identifies a trace file
+KERNEL_STATE FILE *traceFile = NULL; // The trace file being written, or NULL if the kernel is not tracing
+KERNEL_STATE long traceRecords = 0; // The number of records written to the trace file
+
+// Starts writing a trace to the file filename
+// Returns 0, or -1 if the file could not be created or a trace is already being written
+int startTrace(char *filename) {
+	if (traceFile != NULL) {
+		return -1;
+	}
+
+	traceFile = fopen(filename, "wb");
+	if (traceFile == NULL) {
+		return -1;
+	}
+
+	struct TraceHeader header = { .version = TRACE_VERSION, .frameCount = FRAME_COUNT };
+	memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+	fwrite(&header, sizeof(header), 1, traceFile);
+	traceRecords = 0;
+	return 0;
+}
+
+// Stops writing the trace, if any
+// Returns the number of records written, or -1 if the kernel was not tracing
+long stopTrace() {
+	if (traceFile == NULL) {
+		return -1;
+	}
+
+	fclose(traceFile);
+	traceFile = NULL;
+	return traceRecords;
+}
+
+// Returns 1 if the kernel is writing a trace, and 0 otherwise
+int isTracing() {
+	return traceFile != NULL;
+}
+
+// Writes a record to the trace file
+void writeTraceRecord(struct PCB *pcb, int page, int frame, int type) {
+	struct TraceRecord record = { .PID = pcb->PID, .image = pcb->image, .page = page, .frame = frame, .type = type };
+	fwrite(&record, sizeof(record), 1, traceFile);
+	traceRecords++;
+}
+
+// Records that page of PCB pcb was referenced by a dispatch or by the end of the previous page, and was found in frame
+// (or not, if frame is -1)
+void traceAccess(struct PCB *pcb, int page, int frame) {
+	if (traceFile != NULL) {
+		writeTraceRecord(pcb, page, frame, frame == -1 ? TRACE_MISS : TRACE_HIT);
+	}
+}
+
+// Records that page of PCB pcb was mapped into frame
+void traceFault(struct PCB *pcb, int page, int frame) {
+	if (traceFile != NULL) {
+		writeTraceRecord(pcb, page, frame, TRACE_FAULT);
+	}
+}
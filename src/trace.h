@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#include "pcb.h" // For struct PCB
+
+enum {
+	TRACE_VERSION = 1, // The version of the trace format
+	TRACE_HIT = 0, // A dispatch, or a process moving to its next page, referenced a page that was resident
+	TRACE_MISS = 1, // A dispatch, or a process moving to its next page, referenced a page that was not resident
+	TRACE_FAULT = 2 // A page was mapped into a frame by findLoadUpdate(), when a process was launched or took a page fault
+};
+
+// The header of a trace file, which is followed by the records
+struct TraceHeader {
+	char magic[8]; // TRACE_MAGIC
+	uint32_t version; // TRACE_VERSION
+	uint32_t frameCount; // The number of frames of the kernel that recorded the trace
+};
+
+// A record of a trace file
+// The dispatches of the scheduler form the reference string of the trace: a page is identified by its image and its
+// page number, since the processes running the same image share its frames.
+struct TraceRecord {
+	int32_t PID; // The process that referenced or mapped the page
+	int32_t image; // The image of the process
+	uint8_t page; // The page number
+	int8_t frame; // The frame that holds the page, or -1 for a miss
+	uint8_t type; // TRACE_HIT, TRACE_MISS or TRACE_FAULT
+	uint8_t unused;
+};
+
+extern const char TRACE_MAGIC[8];
+
+int startTrace(char *filename);
+long stopTrace();
+int isTracing();
+void traceAccess(struct PCB *pcb, int page, int frame);
+void traceFault(struct PCB *pcb, int page, int frame);
+
+#endif
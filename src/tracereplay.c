@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2021 Christopher Boustros <github.com/christopher-boustros>
+ * SPDX-License-Identifier: MIT
+ */
+// This file implements the tracereplay program, which replays a trace recorded by the 'trace' command
+// The reference string of the trace (the pages referenced by the dispatches of the scheduler) is run through several
+// page replacement policies with several numbers of frames, and the number of misses of every policy is displayed.
+//
+// Usage: tracereplay TRACE [FRAMES...]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+enum {
+	REPLAY_FIFO = 0, // Replace the page that was loaded first
+	REPLAY_CLOCK = 1, // Second chance: replace the first page without a reference bit, clearing the bits on the way
+	REPLAY_LRU = 2, // Replace the least recently referenced page
+	REPLAY_RANDOM = 3, // Replace a random page, like the global replacement of the kernel
+	REPLAY_OPT = 4, // Belady's optimal policy: replace the page that will be referenced last
+	REPLAY_POLICIES = 5,
+	REPLAY_MAX_FRAMES = 4096, // The maximum number of frames that can be replayed
+	REPLAY_SEED = 1 // The seed of the random policy, so that replays are repeatable
+};
+
+const char *policyNames[REPLAY_POLICIES] = { "FIFO", "CLOCK", "LRU", "RANDOM", "OPT" };
+const int defaultFrames[] = { 1, 2, 4, 8, 10, 16, 32 };
+
+// The reference string of a trace
+struct ReferenceString {
+	int *pages; // pages[i] is the page referenced by reference i, as an index into the distinct pages
+	long *nextUse; // nextUse[i] is the index of the next reference to the same page, or count if there is none
+	long count; // The number of references
+	int distinct; // The number of distinct pages
+	long recordedMisses; // The number of references that missed in the kernel
+	long recordedFaults; // The number of pages mapped by the kernel
+};
+
+// A hash table that numbers the distinct pages of a trace, which are identified by their image and page number
+struct PageTable {
+	uint64_t *keys;
+	int *values;
+	long size; // A power of two
+};
+
+// Returns the number of the page identified by key in table, numbering it with *distinct if it is new
+int numberPage(struct PageTable *table, uint64_t key, int *distinct) {
+	long i = (long) ((key * 0x9E3779B97F4A7C15UL) & (table->size - 1));
+	while (table->values[i] != -1) {
+		if (table->keys[i] == key) {
+			return table->values[i];
+		}
+		i = (i + 1) & (table->size - 1);
+	}
+
+	table->keys[i] = key;
+	table->values[i] = (*distinct)++;
+	return table->values[i];
+}
+
+// Reads the reference string of the trace file filename into refs
+// Returns 0, or -1 if the file is not a valid trace
+int readTrace(const char *filename, struct ReferenceString *refs) {
+	FILE *f = fopen(filename, "rb");
+	if (f == NULL) {
+		return -1;
+	}
+
+	struct TraceHeader header;
+	if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != TRACE_VERSION) {
+		fclose(f);
+		return -1;
+	}
+
+	// Every record might be a reference, so the arrays are sized from the size of the file
+	fseek(f, 0, SEEK_END);
+	long records = (ftell(f) - (long) sizeof(header)) / (long) sizeof(struct TraceRecord);
+	fseek(f, sizeof(header), SEEK_SET);
+
+	struct PageTable table = { .size = 16 };
+	while (table.size < 2 * records) {
+		table.size *= 2;
+	}
+	table.keys = (uint64_t *) malloc(table.size * sizeof(uint64_t));
+	table.values = (int *) malloc(table.size * sizeof(int));
+	memset(table.values, -1, table.size * sizeof(int));
+
+	memset(refs, 0, sizeof(*refs));
+	refs->pages = (int *) malloc((records + 1) * sizeof(int));
+	refs->nextUse = (long *) malloc((records + 1) * sizeof(long));
+
+	struct TraceRecord record;
+	while (fread(&record, sizeof(record), 1, f) == 1) {
+		if (record.type == TRACE_FAULT) {
+			refs->recordedFaults++;
+			continue;
+		}
+
+		if (record.type == TRACE_MISS) {
+			refs->recordedMisses++;
+		}
+		uint64_t key = ((uint64_t) (uint32_t) record.image << 8) | record.page;
+		refs->pages[refs->count++] = numberPage(&table, key, &refs->distinct);
+	}
+	fclose(f);
+	free(table.keys);
+	free(table.values);
+
+	// Compute the next use of every reference by scanning the reference string backwards
+	long *lastSeen = (long *) malloc((refs->distinct + 1) * sizeof(long));
+	int p;
+	for (p = 0; p < refs->distinct; p++) {
+		lastSeen[p] = refs->count;
+	}
+	long i;
+	for (i = refs->count - 1; i >= 0; i--) {
+		refs->nextUse[i] = lastSeen[refs->pages[i]];
+		lastSeen[refs->pages[i]] = i;
+	}
+	free(lastSeen);
+
+	return 0;
+}
+
+// Replays the reference string refs with frames frames under policy
+// Returns the number of misses
+long replay(struct ReferenceString *refs, int frames, int policy) {
+	int *frameOf = (int *) malloc((refs->distinct + 1) * sizeof(int)); // The frame of every page, or -1
+	int page[REPLAY_MAX_FRAMES]; // The page in every frame, or -1
+	long stamp[REPLAY_MAX_FRAMES]; // The last reference (LRU) or the next reference (OPT) of the page in every frame
+	char referenced[REPLAY_MAX_FRAMES]; // The reference bit of every frame (CLOCK)
+	int hand = 0; // The next frame to replace (FIFO) or to examine (CLOCK)
+	unsigned int seed = REPLAY_SEED;
+	long misses = 0;
+
+	int p;
+	for (p = 0; p < refs->distinct; p++) {
+		frameOf[p] = -1;
+	}
+	int k;
+	for (k = 0; k < frames; k++) {
+		page[k] = -1;
+		referenced[k] = 0;
+	}
+
+	int used = 0; // The frames are filled in order before any page is replaced
+	long i;
+	for (i = 0; i < refs->count; i++) {
+		int current = refs->pages[i];
+		int frame = frameOf[current];
+
+		if (frame == -1) {
+			misses++;
+			if (used < frames) {
+				frame = used++;
+			} else if (policy == REPLAY_FIFO) {
+				frame = hand;
+				hand = (hand + 1) % frames;
+			} else if (policy == REPLAY_CLOCK) {
+				while (referenced[hand]) {
+					referenced[hand] = 0;
+					hand = (hand + 1) % frames;
+				}
+				frame = hand;
+				hand = (hand + 1) % frames;
+			} else if (policy == REPLAY_RANDOM) {
+				frame = rand_r(&seed) % frames;
+			} else { // LRU replaces the smallest stamp, and OPT the largest
+				frame = 0;
+				for (k = 1; k < frames; k++) {
+					if (policy == REPLAY_LRU ? stamp[k] < stamp[frame] : stamp[k] > stamp[frame]) {
+						frame = k;
+					}
+				}
+			}
+
+			if (page[frame] != -1) {
+				frameOf[page[frame]] = -1;
+			}
+			page[frame] = current;
+			frameOf[current] = frame;
+		}
+
+		referenced[frame] = 1;
+		stamp[frame] = policy == REPLAY_OPT ? refs->nextUse[i] : i;
+	}
+
+	free(frameOf);
+	return misses;
+}
+
+// Replays a trace with the frame counts given on the command line, or with the default frame counts
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printf("Usage: %s TRACE [FRAMES...]\n", argv[0]);
+		return 1;
+	}
+
+	struct ReferenceString refs;
+	if (readTrace(argv[1], &refs) != 0) {
+		printf("Error: '%s' is not a valid trace file\n", argv[1]);
+		return 1;
+	}
+
+	printf("References: %ld to %d distinct pages (%ld misses and %ld page mappings recorded)\n", refs.count,
+			refs.distinct, refs.recordedMisses, refs.recordedFaults);
+	printf("Misses per policy:\n%8s", "Frames");
+	int p;
+	for (p = 0; p < REPLAY_POLICIES; p++) {
+		printf("%10s", policyNames[p]);
+	}
+	printf("\n");
+
+	int count = argc > 2 ? argc - 2 : (int) (sizeof(defaultFrames) / sizeof(defaultFrames[0]));
+	int i;
+	for (i = 0; i < count; i++) {
+		int frames = argc > 2 ? atoi(argv[i + 2]) : defaultFrames[i];
+		if (frames < 1 || frames > REPLAY_MAX_FRAMES) {
+			printf("Error: The number of frames must be between 1 and %d\n", REPLAY_MAX_FRAMES);
+			free(refs.pages);
+			free(refs.nextUse);
+			return 1;
+		}
+
+		printf("%8d", frames);
+		for (p = 0; p < REPLAY_POLICIES; p++) {
+			printf("%10ld", replay(&refs, frames, p));
+		}
+		printf("\n");
+	}
+
+	free(refs.pages);
+	free(refs.nextUse);
+	return 0;
+}
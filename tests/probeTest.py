@@ -0,0 +1,28 @@
+# Builds the program with probes next to the program given as the first argument, runs the same commands with both,
+# and checks that only the build with probes reports them. The latencies vary from run to run, so only the number of
+# calls of every probe is displayed, and the latencies are checked to be ordered.
+import os
+import subprocess
+import sys
+import tempfile
+
+COMMANDS = "exec a.txt b.txt hello.txt\nexec thrash1.txt thrash2.txt thrash3.txt\nrun hello.txt\nquit\n"
+
+# Runs the commands with program, and returns its standard error
+def report(program):
+    return subprocess.run([program], input=COMMANDS, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                          text=True).stderr
+
+root = os.path.join(os.path.dirname(os.path.abspath(sys.argv[1])), "..")
+with tempfile.TemporaryDirectory() as build:
+    subprocess.run(["make", "-s", "-C", root, "PROBES=1", "OBJECTDIR=" + build + "/obj", "TARGETDIR=" + build + "/bin",
+                    build + "/bin/mykernel"], stdout=subprocess.DEVNULL, check=True)
+
+    print("Normal build: %d lines reported" % len(report(sys.argv[1]).splitlines()))
+
+    lines = report(build + "/bin/mykernel").splitlines()
+    print("Build with probes: %s" % " ".join(lines[0].split()[:2]))
+    for line in lines[1:]:
+        name, count, mean, p50, p99, maximum = line.split()
+        ordered = int(p50) <= int(p99) <= int(maximum) and int(mean) <= int(maximum)
+        print("%-16s %10s %s" % (name, count, "ordered" if ordered else "not ordered"))
@@ -0,0 +1,33 @@
+# Redirects a generated input to the program given as the first argument, and checks that the reader thread splits it
+# into the same lines and words whatever their position in its chunks: the input is several chunks long, so lines
+# cross the chunk boundaries, and it holds more lines than the queue between the reader thread and the shell.
+# Like fgets() in the shell, the reader splits a line longer than INSTRUCTION_SIZE - 2 characters into several lines.
+import subprocess
+import sys
+
+CHUNK_SIZE = 65536 # READER_CHUNK_SIZE
+
+lines = []
+size = 0
+i = 0
+while size < 3 * CHUNK_SIZE:
+    line = "set v%d %d%s" % (i % 100, i, "x" * (i % 97))
+    lines.append(line)
+    size += len(line) + 1
+    i += 1
+
+lines.append("set   spaced    words")
+lines.append("print spaced")
+lines.append("print v0")
+lines.append("print v%d" % ((i - 1) % 100))
+lines.append("print v1" + " " * 1000 + "print v2")
+lines.append("print")
+lines.append("")
+lines.append("quit")
+
+program = subprocess.run([sys.argv[1]], input="\n".join(lines), stdout=subprocess.PIPE, text=True)
+
+# The prompts of the set commands are counted rather than displayed
+output = program.stdout.split("$ ")
+print("%d lines, %d prompts" % (len(lines), len(output) - 1))
+print("".join(part for part in output if part != ""), end="")
@@ -0,0 +1,65 @@
+# Starts the program given as the first argument as a server, and checks that its sessions are independent:
+# each session has its own variables and jobs, and a client that stops reading does not hold up the others
+import os
+import signal
+import socket
+import subprocess
+import sys
+import time
+
+SOCKET = "serverTest.sock"
+
+# Connects a client to the server
+def connect():
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    for attempt in range(100):
+        try:
+            client.connect(SOCKET)
+            break
+        except (FileNotFoundError, ConnectionRefusedError):
+            time.sleep(0.05)
+    client.settimeout(10)
+    return client
+
+# Reads the output of a session until its prompt (or until it closes if prompts is 0)
+def receive(client, prompts=1):
+    output = b""
+    while prompts == 0 or output.count(b"$ ") < prompts:
+        data = client.recv(4096)
+        if not data:
+            break
+        output += data
+    return output.decode()
+
+# Sends the lines of commands to a session, and displays what it receives until the last prompt
+# The session ends after 'quit', so everything it receives is displayed.
+def send(name, client, *lines):
+    client.sendall("".join(line + "\n" for line in lines).encode())
+    print("[%s] %s" % (name, " | ".join(lines)))
+    print(receive(client, 0 if lines[-1] == "quit" else len(lines)))
+
+server = subprocess.Popen([sys.argv[1], "--listen", SOCKET], stdout=subprocess.PIPE, text=True)
+print(server.stdout.readline(), end="")
+
+a = connect()
+b = connect()
+print(receive(a))
+receive(b)
+
+send("a", a, "set v alpha")
+send("b", b, "set v beta")
+send("a", a, "print v")
+send("b", b, "print v")
+
+idle = connect() # This client never reads what it receives
+idle.sendall(b"help\n" * 2000)
+
+send("b", b, "exec a.txt b.txt &", "wait")
+send("a", a, "jobs")
+send("a", a, "kill 1")
+send("a", a, "print v")
+send("a", a, "quit")
+
+server.send_signal(signal.SIGINT)
+print(server.stdout.read(), end="")
+server.wait()
@@ -0,0 +1,9 @@
+# Redirects the commands of simulateTest.txt to the program given as the first argument, and displays its output
+# without the wall time of the simulations, which varies from run to run
+import subprocess
+import sys
+
+with open("simulateTest.txt") as commands:
+    output = subprocess.run([sys.argv[1]], stdin=commands, stdout=subprocess.PIPE, text=True).stdout
+
+print("".join(line for line in output.splitlines(True) if not line.startswith("Wall time:")), end="")
@@ -0,0 +1,29 @@
+# Generates a script of several read blocks with lines of any length, runs it with the program given as the first
+# argument, and checks the lines counted by 'runstat'. The throughput varies from run to run, so it is not displayed.
+import os
+import subprocess
+import sys
+
+SCRIPT = "streamTest.gen.txt"
+BLOCK_SIZE = 65536 # The size of the blocks that 'run' reads
+
+lines = []
+size = 0
+i = 0
+while size < 4 * BLOCK_SIZE:
+    lines.append("set s%d %d" % (i % 100, i))
+    size += len(lines[-1]) + 1
+    i += 1
+
+lines.insert(len(lines) // 2, "print" + " " * (2 * BLOCK_SIZE) + "s7") # A line that spans more than a block
+lines.append("set long " + "y" * 5000) # The value is truncated by the shell memory
+lines.append("print s%d" % ((i - 1) % 100))
+with open(SCRIPT, "w") as script:
+    script.write("\n".join(lines)) # The last line does not end with a new line character
+
+commands = "runstat\nrun %s\nrunstat\nrun %s\nrunstat\nquit\n" % (SCRIPT, SCRIPT)
+output = subprocess.run([sys.argv[1]], input=commands, stdout=subprocess.PIPE, text=True).stdout
+os.remove(SCRIPT)
+
+print("%d lines, %d bytes" % (len(lines), sum(len(line) + 1 for line in lines) - 1))
+print("".join(line for line in output.splitlines(True) if not line.startswith("Throughput:")), end="")
@@ -0,0 +1,18 @@
+# Redirects the commands of traceTest.txt to the program given as the first argument, which records a trace, and
+# replays the trace with the tracereplay program built next to it. The misses recorded in the trace are the page faults
+# displayed by 'vmstat', and the replay of the policies with the frames of the kernel starts from the same references.
+import os
+import subprocess
+import sys
+
+TRACE = "traceTest.trc"
+
+with open("traceTest.txt") as commands:
+    print(subprocess.run([sys.argv[1]], stdin=commands, stdout=subprocess.PIPE, text=True).stdout, end="")
+
+replay = os.path.join(os.path.dirname(sys.argv[1]), "tracereplay")
+for arguments in ([TRACE], [TRACE, "1", "10", "40"], [TRACE, "0"], ["traceTest.txt"]):
+    print("$ tracereplay " + " ".join(arguments))
+    print(subprocess.run([replay] + arguments, stdout=subprocess.PIPE, text=True).stdout, end="")
+
+os.remove(TRACE)